@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#elif defined(_WIN32)
+#include <malloc.h>
+#endif
+#include "parser.h"
+#include "document.h"
+#include "handler.h"
+#include "../json_parser/json_parser/Parser.h"
+
+// 统计堆分配：替换全局 operator new/delete，只在单线程中计数
+static size_t g_allocations = 0;
+static size_t g_allocated_bytes = 0;
+
+void *operator new(size_t size)
+{
+    g_allocations++;
+    g_allocated_bytes += size;
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+// pmr 的 new_delete_resource 使用带对齐的版本，arena 的内存块也要计入
+void *operator new(size_t size, std::align_val_t align)
+{
+    g_allocations++;
+    g_allocated_bytes += size;
+    size_t alignment = static_cast<size_t>(align);
+    // aligned_alloc 要求大小是对齐的整数倍
+    size = (size + alignment - 1) / alignment * alignment;
+#if defined(_WIN32)
+    void *p = _aligned_malloc(size == 0 ? alignment : size, alignment);
+#else
+    void *p = std::aligned_alloc(alignment, size == 0 ? alignment : size);
+#endif
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size, std::align_val_t align)
+{
+    return operator new(size, align);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void operator delete[](void *p, std::align_val_t align) noexcept
+{
+    operator delete(p, align);
+}
+
+void operator delete(void *p, size_t, std::align_val_t align) noexcept
+{
+    operator delete(p, align);
+}
+
+void operator delete[](void *p, size_t, std::align_val_t align) noexcept
+{
+    operator delete(p, align);
+}
+
+// 一份待解析的文档
+struct Corpus
+{
+    std::string name;
+    std::string source;
+};
+
+// 一个参与比较的实现，parse 解析一份完整的文档并释放结果
+struct Implementation
+{
+    const char *name;
+    std::function<void(const std::string &)> parse;
+};
+
+// 一次测量的结果
+struct Result
+{
+    size_t iterations;
+    // 最快一轮与平均每份文档的耗时
+    double best_seconds;
+    double mean_seconds;
+    // 解析一份文档的堆分配次数与字节数
+    size_t allocations;
+    size_t allocated_bytes;
+};
+
+std::string readFile(const std::string &path)
+{
+    std::ifstream fin(path, std::ios::binary);
+    if (!fin)
+    {
+        civitasv::json::error("can't open file: " + path);
+    }
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    return ss.str();
+}
+
+// 进程的峰值常驻内存，单位 KB，不支持的平台返回 0
+size_t peakRssKb()
+{
+#if defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+#elif defined(__unix__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+// 数字为主：整数、负数、小数与指数混合
+std::string numbers(size_t count)
+{
+    std::string source = "[";
+    char buffer[64];
+    for (size_t i = 0; i < count; i++)
+    {
+        switch (i % 4)
+        {
+        case 0:
+            snprintf(buffer, sizeof(buffer), "%zu", i * 7919 % 1000003);
+            break;
+        case 1:
+            snprintf(buffer, sizeof(buffer), "-%zu", i * 104729);
+            break;
+        case 2:
+            snprintf(buffer, sizeof(buffer), "%.17g", i * 0.001 + 0.1);
+            break;
+        default:
+            snprintf(buffer, sizeof(buffer), "%.6e", i * 1.5e10);
+            break;
+        }
+        source += i == 0 ? "" : ",";
+        source += buffer;
+    }
+    source += "]";
+    return source;
+}
+
+// 字符串为主：ASCII 文本、中文与转义字符
+std::string strings(size_t count)
+{
+    std::string source = "[";
+    for (size_t i = 0; i < count; i++)
+    {
+        source += i == 0 ? "" : ",";
+        switch (i % 3)
+        {
+        case 0:
+            source += "\"The quick brown fox jumps over the lazy dog " + std::to_string(i) + "\"";
+            break;
+        case 1:
+            source += "\"敏捷的棕色狐狸跳过了懒狗，\\u00e9\\ud83d\\ude00\"";
+            break;
+        default:
+            source += "\"path\\\\to\\\\file\\n\\t\\\"quoted\\\"\"";
+            break;
+        }
+    }
+    source += "]";
+    return source;
+}
+
+// 深层嵌套：count 个深度为 depth 的对象与数组交替嵌套的值
+std::string nested(size_t count, size_t depth)
+{
+    std::string one;
+    for (size_t i = 0; i < depth; i++)
+    {
+        one += i % 2 == 0 ? "{\"a\":" : "[";
+    }
+    one += "1";
+    for (size_t i = depth; i-- > 0;)
+    {
+        one += i % 2 == 0 ? "}" : "]";
+    }
+
+    std::string source = "[";
+    for (size_t i = 0; i < count; i++)
+    {
+        source += i == 0 ? "" : ",";
+        source += one;
+    }
+    source += "]";
+    return source;
+}
+
+// 宽对象：一个有 count 个成员的对象
+std::string wide(size_t count)
+{
+    std::string source = "{";
+    for (size_t i = 0; i < count; i++)
+    {
+        source += i == 0 ? "" : ",";
+        source += "\"key" + std::to_string(i) + "\":" + std::to_string(i);
+    }
+    source += "}";
+    return source;
+}
+
+// 反复解析同一份文档，至少运行 min_seconds 秒、min_iterations 次
+Result measure(const Implementation &implementation, const std::string &source, double min_seconds, size_t min_iterations)
+{
+    using Clock = std::chrono::steady_clock;
+    Result result{};
+
+    // 第一次同时用于预热与统计分配
+    size_t allocations = g_allocations;
+    size_t allocated_bytes = g_allocated_bytes;
+    implementation.parse(source);
+    result.allocations = g_allocations - allocations;
+    result.allocated_bytes = g_allocated_bytes - allocated_bytes;
+
+    double total = 0;
+    result.best_seconds = 1e300;
+    while (total < min_seconds || result.iterations < min_iterations)
+    {
+        auto start = Clock::now();
+        implementation.parse(source);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        total += seconds;
+        result.best_seconds = std::min(result.best_seconds, seconds);
+        result.iterations++;
+    }
+    result.mean_seconds = total / result.iterations;
+    return result;
+}
+
+int main(int argc, const char **argv)
+{
+    // cd ../json_parser/mini_json_parser && g++ -O2 -o json_benchmark ../../benchmark/json_benchmark.cpp scanner.cpp parser.cpp structuralIndex.cpp number.cpp reader.cpp treeBuilder.cpp utf8.cpp ../json_parser/JObject.cpp ../json_parser/Parser.cpp -I. -std=c++17 -pthread && ./json_benchmark ../../test_resources > results.jsonl
+    using namespace civitasv::json;
+
+    std::string resources = argc > 1 ? argv[1] : "../../test_resources";
+    double min_seconds = argc > 2 ? std::stod(argv[2]) : 0.5;
+
+    std::vector<Corpus> corpora = {
+        {"test.json", readFile(resources + "/test.json")},
+        {"test_out_nl.json", readFile(resources + "/test_out_nl.json")},
+        {"numbers", numbers(200000)},
+        {"strings", strings(60000)},
+        {"nested", nested(2000, 500)},
+        {"wide", wide(100000)},
+    };
+
+    // 不构建 DOM 的 handler，用于单独测量词法与语法分析
+    struct NullHandler : JsonHandler
+    {
+    };
+
+    std::vector<Implementation> implementations = {
+        {"mini.heap", [](const std::string &source)
+         {
+             Parser parser{Scanner(std::string_view(source))};
+             delete parser.parse();
+         }},
+        {"mini.arena", [](const std::string &source)
+         {
+             Document document;
+             Parser parser{Scanner(std::string_view(source))};
+             parser.parse(document);
+         }},
+        {"mini.indexed", [](const std::string &source)
+         {
+             Document document;
+             Scanner scanner{std::string_view(source)};
+             scanner.buildIndex();
+             Parser parser{std::move(scanner)};
+             parser.parse(document);
+         }},
+        {"mini.sax", [](const std::string &source)
+         {
+             NullHandler handler;
+             Parser parser{Scanner(std::string_view(source))};
+             parser.parse(handler);
+         }},
+        {"json.fromString", [](const std::string &source)
+         {
+             json::Parser::fromString(source);
+         }},
+        {"json.arena", [](const std::string &source)
+         {
+             std::pmr::monotonic_buffer_resource arena;
+             json::Parser::fromString(source, &arena);
+         }},
+    };
+
+    // 每个实现、每份文档输出一行 JSON，人读的摘要输出到 stderr
+    for (const Corpus &corpus : corpora)
+    {
+        for (const Implementation &implementation : implementations)
+        {
+            Result result = measure(implementation, corpus.source, min_seconds, 3);
+            double mb = corpus.source.size() / (1024.0 * 1024.0);
+            printf("{\"implementation\":\"%s\",\"corpus\":\"%s\",\"bytes\":%zu,\"iterations\":%zu,"
+                   "\"best_mb_per_s\":%.2f,\"mean_mb_per_s\":%.2f,\"allocations_per_doc\":%zu,"
+                   "\"allocated_bytes_per_doc\":%zu,\"peak_rss_kb\":%zu}\n",
+                   implementation.name, corpus.name.c_str(), corpus.source.size(), result.iterations,
+                   mb / result.best_seconds, mb / result.mean_seconds, result.allocations,
+                   result.allocated_bytes, peakRssKb());
+            fprintf(stderr, "%-18s %-14s %10.2f MB/s %10zu allocs/doc\n", corpus.name.c_str(), implementation.name,
+                    mb / result.best_seconds, result.allocations);
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}
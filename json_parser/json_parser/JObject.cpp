@@ -0,0 +1,710 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include "JObject.h"
+
+namespace json
+{
+    ChunkedDict::Chunk::Chunk(map_t map) : map(std::move(map))
+    {
+        this->update();
+    }
+
+    void ChunkedDict::Chunk::update()
+    {
+        this->last = this->map.rbegin()->first;
+    }
+
+    ChunkedDict::ChunkedDict(const ChunkedDict &other, const allocator_type &allocator)
+    {
+        if (const map_t *map = get_if<map_t>(&other.m_items))
+        {
+            this->m_items.emplace<map_t>(*map, allocator);
+            return;
+        }
+        auto &chunks = std::get<Chunks>(other.m_items);
+        Chunks copy{std::pmr::vector<chunk_ptr>(allocator.resource()), chunks.size};
+        copy.list.reserve(chunks.list.size());
+        bool shared = chunks.list.get_allocator().resource() == allocator.resource();
+        for (auto &chunk : chunks.list)
+        {
+            // 交出过引用的段要拷贝，否则通过引用的修改会同时出现在拷贝中
+            copy.list.push_back(shared && !chunk->leaked ? chunk : make_chunk(map_t(chunk->map, allocator)));
+        }
+        this->m_items = std::move(copy);
+    }
+
+    ChunkedDict::ChunkedDict(ChunkedDict &&other) noexcept : m_items(std::move(other.m_items)), m_leaked(other.m_leaked)
+    {
+        other.clear();
+    }
+
+    ChunkedDict::ChunkedDict(ChunkedDict &&other, const allocator_type &allocator)
+        : m_items(other.get_allocator() == allocator ? std::move(other.m_items) : decltype(m_items)(std::in_place_type<map_t>, allocator))
+    {
+        if (this->get_allocator() == other.get_allocator())
+        {
+            // 节点移动过来，指向它们的引用随之转给自己
+            this->m_leaked = other.m_leaked;
+            other.clear();
+        }
+        else
+        {
+            *this = other;
+        }
+    }
+
+    ChunkedDict &ChunkedDict::operator=(const ChunkedDict &other)
+    {
+        if (this != &other)
+        {
+            ChunkedDict copy(other, this->get_allocator());
+            this->m_items = std::move(copy.m_items);
+            this->m_leaked = false;
+        }
+        return *this;
+    }
+
+    ChunkedDict &ChunkedDict::operator=(ChunkedDict &&other)
+    {
+        if (this != &other)
+        {
+            // 分配器不同时只能逐个拷贝
+            if (this->get_allocator() != other.get_allocator())
+            {
+                return *this = static_cast<const ChunkedDict &>(other);
+            }
+            this->m_items = std::move(other.m_items);
+            this->m_leaked = other.m_leaked;
+            other.clear();
+        }
+        return *this;
+    }
+
+    void ChunkedDict::clear() noexcept
+    {
+        this->m_leaked = false;
+        if (map_t *map = get_if<map_t>(&this->m_items))
+        {
+            map->clear();
+            return;
+        }
+        // 切分的形式换回空的 map
+        this->m_items.emplace<map_t>(this->get_allocator());
+    }
+
+    ChunkedDict::iterator ChunkedDict::begin()
+    {
+        return this->chunk_count() == 0 ? this->end() : iterator(this, 0, this->enter(0).begin());
+    }
+
+    ChunkedDict::const_iterator ChunkedDict::begin() const
+    {
+        return this->chunk_count() == 0 ? this->end() : const_iterator(this, 0, this->chunk(0).begin());
+    }
+
+    ChunkedDict::iterator ChunkedDict::find(string_view key)
+    {
+        // 先只读地查找，key 不存在时不拷贝共享的段
+        size_t index = this->chunk_of(key);
+        if (this->chunk(index).find(key) == this->chunk(index).end())
+        {
+            return this->end();
+        }
+        return iterator(this, index, this->own(index).find(key));
+    }
+
+    ChunkedDict::const_iterator ChunkedDict::find(string_view key) const
+    {
+        size_t index = this->chunk_of(key);
+        const map_t &map = this->chunk(index);
+        auto it = map.find(key);
+        return it == map.end() ? this->end() : const_iterator(this, index, it);
+    }
+
+    JObject &ChunkedDict::at(string_view key)
+    {
+        auto it = this->find(key);
+        if (it == this->end())
+        {
+            throw std::logic_error("key not found! ChunkedDict::at()");
+        }
+        return it->second;
+    }
+
+    const JObject &ChunkedDict::at(string_view key) const
+    {
+        auto it = this->find(key);
+        if (it == this->end())
+        {
+            throw std::logic_error("key not found! ChunkedDict::at()");
+        }
+        return it->second;
+    }
+
+    JObject &ChunkedDict::operator[](string_view key)
+    {
+        size_t index = this->chunk_of(key);
+        map_t &map = this->own(index);
+        auto it = map.lower_bound(key);
+        if (it != map.end() && it->first == key)
+        {
+            // 通过迭代器取引用，标记所在的段
+            return iterator(this, index, it)->second;
+        }
+        it = map.emplace_hint(it, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+        // 拆开段之后 it 可能在下一段，同样通过迭代器标记
+        return this->inserted(index, it)->second;
+    }
+
+    JObject *ChunkedDict::member(string_view key)
+    {
+        size_t index = this->chunk_of(key);
+        if (this->chunk(index).find(key) == this->chunk(index).end())
+        {
+            return nullptr;
+        }
+        return &this->own(index).find(key)->second;
+    }
+
+    std::pair<ChunkedDict::iterator, bool> ChunkedDict::emplace(str_t key, JObject value)
+    {
+        return this->insert(std::move(key), std::move(value), false);
+    }
+
+    ChunkedDict::iterator ChunkedDict::emplace_hint(const_iterator hint, str_t key, JObject value)
+    {
+        size_t count = this->chunk_count();
+        if (hint == this->cend() && (count == 0 || string_view(this->chunk(count - 1).rbegin()->first) < key))
+        {
+            size_t index = count == 0 ? 0 : count - 1;
+            map_t &map = this->own(index);
+            return this->inserted(index, map.emplace_hint(map.end(), std::move(key), std::move(value)));
+        }
+        return this->emplace(std::move(key), std::move(value)).first;
+    }
+
+    std::pair<ChunkedDict::iterator, bool> ChunkedDict::insert_or_assign(str_t &&key, JObject &&value)
+    {
+        return this->insert(std::move(key), std::move(value), true);
+    }
+
+    std::pair<ChunkedDict::iterator, bool> ChunkedDict::insert(str_t &&key, JObject &&value, bool assign)
+    {
+        if (map_t *map = get_if<map_t>(&this->m_items))
+        {
+            // 还没有切分时与 std::map 相同，只在超过一段时转为切分的形式
+            auto [it, inserted] = assign ? map->insert_or_assign(std::move(key), std::move(value))
+                                         : map->try_emplace(std::move(key), std::move(value));
+            if (!inserted || map->size() <= max_chunk)
+            {
+                return {iterator(this, 0, it), inserted};
+            }
+            return {this->inserted(0, it), true};
+        }
+        size_t index = this->chunk_of(key);
+        map_t &map = this->own(index);
+        auto it = map.lower_bound(key);
+        if (it != map.end() && it->first == key)
+        {
+            if (assign)
+            {
+                it->second = std::move(value);
+            }
+            return {iterator(this, index, it), false};
+        }
+        it = map.emplace_hint(it, std::move(key), std::move(value));
+        return {this->inserted(index, it), true};
+    }
+
+    ChunkedDict::iterator ChunkedDict::erase(const_iterator pos)
+    {
+        size_t index = pos.m_chunk;
+        // pos 所在的段被共享时，拷贝之后在自己的这一份中找到同一个成员
+        const map_t *shared = &this->chunk(index);
+        map_t &map = this->own(index);
+        auto next = map.erase(&map == shared ? pos.m_it : map.find(pos->first));
+        if (Chunks *chunks = get_if<Chunks>(&this->m_items))
+        {
+            chunks->size--;
+            if (map.empty())
+            {
+                chunks->list.erase(chunks->list.begin() + index);
+                if (chunks->list.empty())
+                {
+                    this->clear();
+                }
+                return index < this->chunk_count() ? iterator(this, index, this->enter(index).begin()) : this->end();
+            }
+            if (next == map.end())
+            {
+                // 删除的是这一段最大的 key
+                chunks->list[index]->update();
+            }
+        }
+        if (next == map.end())
+        {
+            return index + 1 < this->chunk_count() ? iterator(this, index + 1, this->enter(index + 1).begin()) : this->end();
+        }
+        return iterator(this, index, next);
+    }
+
+    ChunkedDict::size_type ChunkedDict::erase(string_view key)
+    {
+        auto it = static_cast<const ChunkedDict *>(this)->find(key);
+        if (it == this->cend())
+        {
+            return 0;
+        }
+        this->erase(it);
+        return 1;
+    }
+
+    ChunkedDict::map_t &ChunkedDict::own(size_t index)
+    {
+        if (map_t *map = get_if<map_t>(&this->m_items))
+        {
+            return *map;
+        }
+        chunk_ptr &chunk = std::get<Chunks>(this->m_items).list[index];
+        if (chunk.use_count() > 1)
+        {
+            // 只拷贝这一段，成员的值仍与原来的段共享各自的 list 与 dict
+            chunk = make_chunk(map_t(chunk->map, chunk->map.get_allocator()));
+        }
+        return chunk->map;
+    }
+
+    size_t ChunkedDict::chunk_of(string_view key) const
+    {
+        const Chunks *chunks = get_if<Chunks>(&this->m_items);
+        if (chunks == nullptr)
+        {
+            return 0;
+        }
+        // 第一个最大 key 不小于 key 的段，都小于 key 时为最后一段
+        auto it = std::partition_point(chunks->list.begin(), chunks->list.end(), [key](const chunk_ptr &chunk)
+                                       { return chunk->last < key; });
+        return it == chunks->list.end() ? chunks->list.size() - 1 : size_t(it - chunks->list.begin());
+    }
+
+    ChunkedDict::chunk_ptr ChunkedDict::make_chunk(map_t &&map)
+    {
+        std::pmr::polymorphic_allocator<Chunk> allocator(map.get_allocator().resource());
+        return std::allocate_shared<Chunk>(allocator, std::move(map));
+    }
+
+    ChunkedDict::iterator ChunkedDict::inserted(size_t index, map_t::iterator it)
+    {
+        if (map_t *map = get_if<map_t>(&this->m_items))
+        {
+            if (map->size() <= max_chunk)
+            {
+                return iterator(this, 0, it);
+            }
+            // 转为切分的形式，原来的 map 整个移动过去作为第一段，节点不重新分配
+            Chunks chunks{std::pmr::vector<chunk_ptr>(map->get_allocator().resource()), map->size()};
+            chunks.list.reserve(2);
+            chunks.list.push_back(make_chunk(std::move(*map)));
+            chunks.list.back()->leaked = this->m_leaked;
+            this->m_items = std::move(chunks);
+        }
+        else
+        {
+            std::get<Chunks>(this->m_items).size++;
+        }
+
+        auto &list = std::get<Chunks>(this->m_items).list;
+        map_t &map = list[index]->map;
+        if (map.size() <= max_chunk)
+        {
+            if (std::next(it) == map.end())
+            {
+                list[index]->update();
+            }
+            return iterator(this, index, it);
+        }
+        // 在最后一段的末尾追加时只移出最后一个成员，前面的段保持是满的；否则对半拆开
+        bool append = index + 1 == list.size() && std::next(it) == map.end();
+        size_t keep = append ? map.size() - 1 : map.size() / 2;
+        map_t next(map.get_allocator());
+        bool moved = false;
+        // 节点直接移动到新的段中，不重新分配，移动 map 之后迭代器仍然有效
+        for (auto first = std::next(map.begin(), keep); first != map.end();)
+        {
+            moved = moved || first == it;
+            next.insert(next.end(), map.extract(first++));
+        }
+        list[index]->update();
+        list.insert(list.begin() + index + 1, make_chunk(std::move(next)));
+        // 引用可能指向移过去的任何一个成员
+        list[index + 1]->leaked = list[index]->leaked;
+        return iterator(this, moved ? index + 1 : index, it);
+    }
+
+    JObject::list_ptr JObject::make_list(list_t value)
+    {
+        // 控制块与 list_t 一起分配在 value 的 memory_resource 上，list_t 直接移动过去
+        std::pmr::polymorphic_allocator<Shared<list_t>> allocator(value.get_allocator().resource());
+        return std::allocate_shared<Shared<list_t>>(allocator, std::move(value));
+    }
+
+    JObject::dict_ptr JObject::make_dict(dict_t value)
+    {
+        std::pmr::polymorphic_allocator<Shared<dict_t>> allocator(value.get_allocator().resource());
+        return std::allocate_shared<Shared<dict_t>>(allocator, std::move(value));
+    }
+
+    void JObject::detach()
+    {
+        // 只拷贝这一层，元素仍与原来的容器共享各自的 list 与 dict
+        if (list_ptr *list = get_if<list_ptr>(&this->m_value))
+        {
+            if (list->use_count() > 1)
+            {
+                *list = make_list(list_t((*list)->value, (*list)->value.get_allocator()));
+            }
+        }
+        else if (dict_ptr *dict = get_if<dict_ptr>(&this->m_value))
+        {
+            if (dict->use_count() > 1)
+            {
+                *dict = make_dict(dict_t((*dict)->value, (*dict)->value.get_allocator()));
+            }
+        }
+    }
+
+    void JObject::leak()
+    {
+        if (list_ptr *list = get_if<list_ptr>(&this->m_value))
+        {
+            (*list)->leaked = true;
+        }
+        else if (dict_ptr *dict = get_if<dict_ptr>(&this->m_value))
+        {
+            (*dict)->leaked = true;
+        }
+    }
+
+    JObject::value_t JObject::share(std::pmr::memory_resource *resource) const
+    {
+        // 拷贝这一层时元素以 resource 构造，仍按同样的规则共享：已在 resource 上且没有交出过引用时只增加引用计数
+        const list_ptr *list = get_if<list_ptr>(&this->m_value);
+        if (list != nullptr && ((*list)->leaked || (*list)->value.get_allocator().resource() != resource))
+        {
+            return make_list(list_t((*list)->value, resource));
+        }
+        const dict_ptr *dict = get_if<dict_ptr>(&this->m_value);
+        if (dict != nullptr && ((*dict)->leaked || (*dict)->value.get_allocator().resource() != resource))
+        {
+            return make_dict(dict_t((*dict)->value, resource));
+        }
+        const str_t *str = get_if<str_t>(&this->m_value);
+        if (str != nullptr)
+        {
+            return value_t(std::in_place_type<str_t>, *str, resource);
+        }
+        return this->m_value;
+    }
+
+    std::pmr::memory_resource *JObject::resource() const
+    {
+        if (const list_ptr *list = get_if<list_ptr>(&this->m_value))
+        {
+            return (*list)->value.get_allocator().resource();
+        }
+        if (const dict_ptr *dict = get_if<dict_ptr>(&this->m_value))
+        {
+            return (*dict)->value.get_allocator().resource();
+        }
+        return nullptr;
+    }
+
+    JObject JObject::clone(std::pmr::memory_resource *resource) const
+    {
+        switch (this->Type())
+        {
+        case T_STR:
+            return JObject(str_t(Value<str_t>(), resource));
+        case T_LIST:
+        {
+            list_t list(resource);
+            list.reserve(Value<list_t>().size());
+            for (auto &item : Value<list_t>())
+            {
+                list.push_back(item.clone(resource));
+            }
+            return JObject(std::move(list));
+        }
+        case T_DICT:
+        {
+            dict_t dict(resource);
+            for (auto &[key, item] : Value<dict_t>())
+            {
+                // key 直接构造在 resource 上，按顺序追加
+                dict.emplace_hint(dict.end(), str_t(key, resource), item.clone(resource));
+            }
+            return JObject(std::move(dict));
+        }
+        default:
+            return *this;
+        }
+    }
+
+    bool JObject::operator==(const JObject &other) const
+    {
+        TYPE type = this->Type();
+        TYPE other_type = other.Type();
+        if ((type == T_INT || type == T_DOUBLE) && (other_type == T_INT || other_type == T_DOUBLE))
+        {
+            if (type == T_INT && other_type == T_INT)
+            {
+                return Value<int_t>() == other.Value<int_t>();
+            }
+            double_t a = type == T_INT ? double_t(Value<int_t>()) : Value<double_t>();
+            double_t b = other_type == T_INT ? double_t(other.Value<int_t>()) : other.Value<double_t>();
+            return a == b;
+        }
+        if (type != other_type)
+        {
+            return false;
+        }
+
+        switch (type)
+        {
+        case T_NULL:
+            return true;
+        case T_BOOL:
+            return Value<bool_t>() == other.Value<bool_t>();
+        case T_STR:
+            return Value<str_t>() == other.Value<str_t>();
+        case T_LIST:
+        {
+            auto &list = Value<list_t>();
+            auto &other_list = other.Value<list_t>();
+            // 共享同一个容器
+            if (&list == &other_list)
+            {
+                return true;
+            }
+            return list.size() == other_list.size() && std::equal(list.begin(), list.end(), other_list.begin());
+        }
+        default:
+        {
+            auto &dict = Value<dict_t>();
+            auto &other_dict = other.Value<dict_t>();
+            if (&dict == &other_dict)
+            {
+                return true;
+            }
+            return dict.size() == other_dict.size() && std::equal(dict.begin(), dict.end(), other_dict.begin());
+        }
+        }
+    }
+
+    size_t MemoryUsage::node_count() const
+    {
+        size_t count = 0;
+        for (size_t n : this->nodes)
+        {
+            count += n;
+        }
+        return count;
+    }
+
+    size_t MemoryUsage::total_bytes() const
+    {
+        return sizeof(JObject) + this->string_bytes + this->list_bytes + this->dict_bytes;
+    }
+
+    // 超出 SSO 的字符串在堆上占用 capacity + 1 字节
+    static size_t string_heap_bytes(const str_t &str)
+    {
+        static const size_t sso_capacity = str_t().capacity();
+        return str.capacity() > sso_capacity ? str.capacity() + 1 : 0;
+    }
+
+    MemoryUsage JObject::memory_usage() const
+    {
+        MemoryUsage usage;
+        this->memory_usage(usage);
+        return usage;
+    }
+
+    void JObject::memory_usage(MemoryUsage &usage) const
+    {
+        // allocate_shared 的控制块：虚表指针、两个引用计数与分配器
+        static constexpr size_t shared_bytes = 3 * sizeof(void *);
+        usage.nodes[this->Type()]++;
+        switch (this->Type())
+        {
+        case T_STR:
+            usage.string_bytes += string_heap_bytes(Value<str_t>());
+            break;
+        case T_LIST:
+        {
+            auto &list = Value<list_t>();
+            usage.list_bytes += shared_bytes + sizeof(Shared<list_t>) + list.capacity() * sizeof(JObject);
+            for (auto &item : list)
+            {
+                item.memory_usage(usage);
+            }
+            break;
+        }
+        case T_DICT:
+        {
+            // libstdc++ 与 libc++ 的红黑树节点都是颜色加三个指针的头部，再加上 pair
+            static constexpr size_t node_bytes = sizeof(dict_t::value_type) + 4 * sizeof(void *);
+            auto &dict = Value<dict_t>();
+            usage.dict_bytes += shared_bytes + sizeof(Shared<dict_t>) + dict.size() * node_bytes;
+            // 切分之后还有段的数组与各段
+            if (auto *chunks = get_if<dict_t::Chunks>(&dict.m_items))
+            {
+                usage.dict_bytes += chunks->list.capacity() * sizeof(dict_t::chunk_ptr) + chunks->list.size() * (shared_bytes + sizeof(dict_t::Chunk));
+            }
+            for (auto &[key, item] : dict)
+            {
+                usage.string_bytes += string_heap_bytes(key);
+                item.memory_usage(usage);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    void dump_string(string &out, string_view str)
+    {
+        out.push_back('\"');
+        size_t run = 0;
+        for (size_t i = 0; i < str.size(); i++)
+        {
+            char c = str[i];
+            // 不需要转义的字符整段追加
+            if (c != '\"' && c != '\\' && (unsigned char)c >= 0x20)
+            {
+                continue;
+            }
+            out.append(str.data() + run, i - run);
+            run = i + 1;
+            switch (c)
+            {
+            case '\"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            case '\b':
+                out += "\\b";
+                break;
+            case '\f':
+                out += "\\f";
+                break;
+            default:
+            {
+                char buffer[8];
+                snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                out += buffer;
+                break;
+            }
+            }
+        }
+        out.append(str.data() + run, str.size() - run);
+        out.push_back('\"');
+    }
+
+    void dump_double(string &out, double_t value)
+    {
+        // inf 与 nan 无法用 json 表示，输出为 null
+        if (!std::isfinite(value))
+        {
+            out += "null";
+            return;
+        }
+        char buffer[32];
+#if defined(__cpp_lib_to_chars)
+        // 能读回同一个 double 的最短表示，比 snprintf 快得多
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+#else
+        // 17 位有效数字保证读回后是同一个 double
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
+        out += buffer;
+#endif
+    }
+
+    string JObject::to_string() const
+    {
+        string out;
+        this->dump(out);
+        return out;
+    }
+
+    void JObject::dump(string &out) const
+    {
+        switch (this->Type())
+        {
+        case T_NULL:
+            out += "null";
+            break;
+        case T_BOOL:
+            out += Value<bool_t>() ? "true" : "false";
+            break;
+        case T_INT:
+            out += std::to_string(Value<int_t>());
+            break;
+        case T_DOUBLE:
+            dump_double(out, Value<double_t>());
+            break;
+        case T_STR:
+            dump_string(out, Value<str_t>());
+            break;
+        case T_LIST:
+        {
+            out.push_back('[');
+            bool first = true;
+            for (auto &item : Value<list_t>())
+            {
+                if (!first)
+                {
+                    out.push_back(',');
+                }
+                item.dump(out);
+                first = false;
+            }
+            out.push_back(']');
+            break;
+        }
+        case T_DICT:
+        {
+            out.push_back('{');
+            bool first = true;
+            for (auto &[key, item] : Value<dict_t>())
+            {
+                if (!first)
+                {
+                    out.push_back(',');
+                }
+                dump_string(out, key);
+                out.push_back(':');
+                item.dump(out);
+                first = false;
+            }
+            out.push_back('}');
+            break;
+        }
+        }
+    }
+}
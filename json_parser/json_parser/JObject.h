@@ -2,9 +2,14 @@
 #define MYUTIL_JOBJECT_H
 
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <variant>
+#include <functional>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <vector>
 #include <string>
 #include <string_view>
@@ -20,7 +25,7 @@ namespace json
     using std::variant;
     using std::vector;
 
-    // 枚举 json 类型
+    // 枚举 json 类型，顺序与 JObject::value_t 中的类型一一对应
     enum TYPE
     {
         T_NULL,
@@ -33,14 +38,19 @@ namespace json
     };
 
     class JObject;
+    class Parser;
+    class Patch;
+    class ChunkedDict;
 
-    using null_t = string;
+    using null_t = std::monostate;
     using int_t = int64_t;
     using bool_t = bool;
     using double_t = double;
-    using str_t = string;
-    using list_t = vector<JObject>;
-    using dict_t = map<string, JObject>;
+    // 容器与字符串都使用 std::pmr 的分配器，默认从 std::pmr::get_default_resource() 分配
+    using str_t = std::pmr::string;
+    using list_t = std::pmr::vector<JObject>;
+    // 按 key 排序，接口与 std::map 相同，见 ChunkedDict
+    using dict_t = ChunkedDict;
 
     // std::is_same 判断模板的类型，std::decay 把类型退化为基本形态
 #define IS_TYPE(type_a, type_b) std::is_same<type_a, type_b>::value
@@ -57,22 +67,448 @@ namespace json
         return false;
     }
 
+    // 一棵 JObject 树占用的内存，由 JObject::memory_usage() 统计
+    struct MemoryUsage
+    {
+        // 按 TYPE 统计的节点数
+        size_t nodes[T_DICT + 1]{};
+        // 字符串与 dict 的 key 超出 SSO 之后在堆上的内存
+        size_t string_bytes = 0;
+        // list_t 本身与元素数组，元素数组按 capacity 计
+        size_t list_bytes = 0;
+        // dict_t 本身、红黑树的节点，以及切分之后的各段
+        size_t dict_bytes = 0;
+
+        size_t node_count() const;
+
+        // 包括根节点本身
+        size_t total_bytes() const;
+    };
+
+    // 追加带引号、转义后的字符串
+    void dump_string(string &out, string_view str);
+
+    // 追加小数，inf 与 nan 输出为 null
+    void dump_double(string &out, double_t value);
+
+    // dict_t 的实现。成员不超过 max_chunk 个时就是一棵 std::pmr::map；
+    // 超过之后按 key 切成若干段（chunk），每段是一棵最多 max_chunk 个成员的 map，段由多个 dict 共享
+    // 拷贝 dict 只拷贝各段的指针，修改一个成员时只拷贝它所在的那一段，代价与 dict 的宽度无关
+    // 与 std::map 一样，成员插入后地址不变，其他成员的插入与删除不会使引用失效；
+    // 但段被拆开时会使迭代器失效，与 std::unordered_map 重新哈希时相同
+    // 交出过成员可写引用的段（leaked）不再与拷贝共享，拷贝 dict 时这些段逐个拷贝
+    class ChunkedDict
+    {
+        // JObject::memory_usage() 统计各段占用的内存
+        friend class JObject;
+
+    public:
+        // std::less<> 支持直接用 string_view、const char* 查找，不构造 string
+        using map_t = std::pmr::map<str_t, JObject, std::less<>>;
+        using key_type = str_t;
+        using mapped_type = JObject;
+        using value_type = map_t::value_type;
+        using size_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using allocator_type = map_t::allocator_type;
+
+        // 每段最多的成员数，修改一个成员时最多拷贝这么多个成员
+        static constexpr size_t max_chunk = 32;
+
+    private:
+        struct Chunk
+        {
+            map_t map;
+            // 最大的 key，指向最后一个节点，查找所在的段时不必访问 map 的内部
+            string_view last;
+            // 交出过成员的可写引用，这些引用直接指向这一段的节点，拷贝 dict 时不能共享
+            bool leaked = false;
+
+            // map 不为空
+            explicit Chunk(map_t map);
+
+            // map 的最后一个成员变化之后调用
+            void update();
+        };
+        using chunk_ptr = std::shared_ptr<Chunk>;
+
+        // 切分之后的各段，按 key 排序，都不为空
+        struct Chunks
+        {
+            std::pmr::vector<chunk_ptr> list;
+            size_t size = 0;
+        };
+
+        // 成员较少时直接是 map，不多占内存与分配次数
+        variant<map_t, Chunks> m_items;
+        // 未切分时是否交出过成员的可写引用，切分时转给各段
+        bool m_leaked = false;
+
+        template <bool Const>
+        class basic_iterator
+        {
+            friend class ChunkedDict;
+            friend class basic_iterator<!Const>;
+            using dict_type = std::conditional_t<Const, const ChunkedDict, ChunkedDict>;
+            using map_iterator = std::conditional_t<Const, map_t::const_iterator, map_t::iterator>;
+
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = ChunkedDict::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+            using reference = std::conditional_t<Const, const value_type &, value_type &>;
+
+            basic_iterator() = default;
+
+            // iterator 可以转换为 const_iterator
+            template <bool C = Const, class = std::enable_if_t<C>>
+            basic_iterator(const basic_iterator<false> &other) : m_dict(other.m_dict), m_chunk(other.m_chunk), m_it(other.m_it) {}
+
+            // 可写的迭代器交出成员的引用，所在的段此后不再共享
+            reference operator*() const
+            {
+                if constexpr (!Const)
+                {
+                    this->m_dict->leak(this->m_chunk);
+                }
+                return *this->m_it;
+            }
+
+            pointer operator->() const
+            {
+                return &**this;
+            }
+
+            // 可写的迭代器进入一段时先拷贝被共享的这一段
+            basic_iterator &operator++()
+            {
+                if (++this->m_it == this->m_dict->chunk(this->m_chunk).end())
+                {
+                    this->m_chunk++;
+                    this->m_it = this->m_chunk < this->m_dict->chunk_count() ? this->m_dict->enter(this->m_chunk).begin() : map_iterator();
+                }
+                return *this;
+            }
+
+            basic_iterator operator++(int)
+            {
+                basic_iterator old = *this;
+                ++*this;
+                return old;
+            }
+
+            basic_iterator &operator--()
+            {
+                if (this->m_chunk == this->m_dict->chunk_count() || this->m_it == this->m_dict->chunk(this->m_chunk).begin())
+                {
+                    this->m_chunk--;
+                    this->m_it = this->m_dict->enter(this->m_chunk).end();
+                }
+                --this->m_it;
+                return *this;
+            }
+
+            basic_iterator operator--(int)
+            {
+                basic_iterator old = *this;
+                --*this;
+                return old;
+            }
+
+            friend bool operator==(const basic_iterator &a, const basic_iterator &b)
+            {
+                return a.m_chunk == b.m_chunk && a.m_it == b.m_it;
+            }
+
+            friend bool operator!=(const basic_iterator &a, const basic_iterator &b)
+            {
+                return !(a == b);
+            }
+
+        private:
+            basic_iterator(dict_type *dict, size_t chunk, map_iterator it) : m_dict(dict), m_chunk(chunk), m_it(it) {}
+
+            dict_type *m_dict = nullptr;
+            // 所在的段，end() 为段数
+            size_t m_chunk = 0;
+            // end() 为默认构造的迭代器
+            map_iterator m_it;
+        };
+
+    public:
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+
+        ChunkedDict() = default;
+
+        // 接受 memory_resource *，与 std::pmr 容器相同
+        explicit ChunkedDict(const allocator_type &allocator) : m_items(std::in_place_type<map_t>, allocator) {}
+
+        // 与 std::pmr 容器相同，拷贝使用默认的 memory_resource
+        ChunkedDict(const ChunkedDict &other) : ChunkedDict(other, allocator_type()) {}
+
+        // 分配器相同时与 other 共享各段，否则逐段拷贝到 allocator 上
+        ChunkedDict(const ChunkedDict &other, const allocator_type &allocator);
+
+        // 移动之后 other 为空
+        ChunkedDict(ChunkedDict &&other) noexcept;
+
+        // 分配器相同时移动，否则拷贝；allocate_shared 等 uses-allocator 构造会调用这个重载
+        ChunkedDict(ChunkedDict &&other, const allocator_type &allocator);
+
+        // 与 std::pmr 容器相同，赋值不改变自己的分配器
+        ChunkedDict &operator=(const ChunkedDict &other);
+
+        ChunkedDict &operator=(ChunkedDict &&other);
+
+        allocator_type get_allocator() const;
+
+        size_type size() const;
+
+        bool empty() const
+        {
+            return this->size() == 0;
+        }
+
+        void clear() noexcept;
+
+        iterator begin();
+
+        const_iterator begin() const;
+
+        iterator end()
+        {
+            return iterator(this, this->chunk_count(), {});
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator(this, this->chunk_count(), {});
+        }
+
+        const_iterator cbegin() const
+        {
+            return this->begin();
+        }
+
+        const_iterator cend() const
+        {
+            return this->end();
+        }
+
+        iterator find(string_view key);
+
+        const_iterator find(string_view key) const;
+
+        size_type count(string_view key) const
+        {
+            return this->find(key) != this->end() ? 1 : 0;
+        }
+
+        bool contains(string_view key) const
+        {
+            return this->count(key) != 0;
+        }
+
+        JObject &at(string_view key);
+
+        const JObject &at(string_view key) const;
+
+        // key 不存在时插入 null，只有插入时才构造 string
+        JObject &operator[](string_view key);
+
+        // key 已存在时不插入，返回已有的成员
+        std::pair<iterator, bool> emplace(str_t key, JObject value);
+
+        // 与 std::map 相同，hint 为 end() 且 key 大于已有的所有 key 时直接追加到最后一段，
+        // 按顺序构建时每段都是满的；否则与 emplace() 相同
+        iterator emplace_hint(const_iterator hint, str_t key, JObject value);
+
+        // key 与 value 都移动进来，解析时每个成员都经过这里
+        std::pair<iterator, bool> insert_or_assign(str_t &&key, JObject &&value);
+
+        // 返回下一个成员
+        iterator erase(const_iterator pos);
+
+        size_type erase(string_view key);
+
+    private:
+        size_t chunk_count() const;
+
+        // 第 index 段，未切分时只有一段
+        const map_t &chunk(size_t index) const;
+
+        // 第 index 段被其他 dict 共享时先拷贝一份，之后可以修改
+        map_t &own(size_t index);
+
+        // 第 index 段交出了成员的可写引用
+        void leak(size_t index);
+
+        // 可写地查找，不存在时返回 nullptr；不标记 leaked，只在引用不会交给调用方的地方使用
+        JObject *member(string_view key);
+
+        // 迭代器进入第 index 段
+        map_t &enter(size_t index)
+        {
+            return this->own(index);
+        }
+
+        const map_t &enter(size_t index) const
+        {
+            return this->chunk(index);
+        }
+
+        // key 所在或应当插入的段，未切分时为 0
+        size_t chunk_of(string_view key) const;
+
+        // 在 map 的 memory_resource 上分配
+        static chunk_ptr make_chunk(map_t &&map);
+
+        // 刚在第 index 段插入了 it，这一段超出 max_chunk 时拆开，返回 it 拆开后的位置
+        iterator inserted(size_t index, map_t::iterator it);
+
+        // key 已存在时 assign 为 true 才替换
+        std::pair<iterator, bool> insert(str_t &&key, JObject &&value, bool assign);
+    };
+
     class JObject
     {
+        // Parser::toJson 直接写入 JObject 成员
+        friend class Parser;
+        // Patch 沿路径修改时不交出引用，使用不标记 leaked 的 unshared()、member()
+        friend class Patch;
+
     private:
-        using value_t = variant<bool_t, int_t, double_t, str_t, list_t, dict_t>;
-        // 根据类型获取值的地址，直接硬转为 void* 类型，然后外界调用 Value 函数进行类型的强转
-        void *value();
+        // list 与 dict 放在各自的 memory_resource 上，由多个 JObject 共享，修改前再拷贝（copy-on-write）
+        // 拷贝 JObject 时已在目标 memory_resource 上的容器只增加引用计数；修改一棵大树中的一处时，从根到这一处路径上的每个容器拷贝一次：
+        // dict 只拷贝各段的指针与被修改的那一段，最多 ChunkedDict::max_chunk 个成员；
+        // list 拷贝整个元素数组，其中的字符串也要拷贝；嵌套的 list 与 dict 都只增加引用计数
+        template <class T>
+        struct Shared
+        {
+            T value;
+            // 通过 Value<T>()、operator[] 等交出过可写的引用。这些引用直接指向这个容器，
+            // 之后的拷贝如果仍然共享它，通过引用的修改会同时出现在拷贝中，因此拷贝 JObject 时拷贝这一层
+            bool leaked = false;
+
+            explicit Shared(T &&value) : value(std::move(value)) {}
+        };
+        using list_ptr = std::shared_ptr<Shared<list_t>>;
+        using dict_ptr = std::shared_ptr<Shared<dict_t>>;
+        // variant 的下标即为 TYPE，不再单独保存类型
+        using value_t = variant<null_t, bool_t, int_t, double_t, str_t, list_ptr, dict_ptr>;
+
+        // 在 value 的 memory_resource 上分配
+        static list_ptr make_list(list_t value);
+
+        static dict_ptr make_dict(dict_t value);
+
+        // list 或 dict 被其他 JObject 共享时拷贝一份，之后可以修改
+        void detach();
+
+        // 标记 list 或 dict 交出过可写的引用
+        void leak();
+
+        // 拷贝到 resource 上时使用的值：已在 resource 上的 list 与 dict 共享，
+        // 不在 resource 上或 leaked 的容器拷贝这一层到 resource 上
+        value_t share(std::pmr::memory_resource *resource) const;
+
+        // list 与 dict 所在的 memory_resource，其他类型返回 nullptr
+        std::pmr::memory_resource *resource() const;
+
+        // 与 Value() 相同，但不标记 leaked，只在引用不会交给调用方的地方使用
+        template <class V>
+        V &unshared()
+        {
+            if constexpr (IS_TYPE(V, list_t) || IS_TYPE(V, dict_t))
+            {
+                this->detach();
+            }
+            return const_cast<V &>(static_cast<const JObject *>(this)->Value<V>());
+        }
+
+        // 可写地查找成员，不存在时返回 nullptr，不标记 leaked
+        JObject *member(string_view key)
+        {
+            return this->unshared<dict_t>().member(key);
+        }
+
+        // 先置为 null 再移动构造，容器连同分配器一起移动，不会逐个元素地搬到原来的分配器上
+        void replace(value_t value) noexcept
+        {
+            this->m_value = null_t();
+            this->m_value = std::move(value);
+        }
+
+        void memory_usage(MemoryUsage &usage) const;
+
+        // 追加到 out 末尾，嵌套的值不再产生临时字符串
+        void dump(string &out) const;
 
     private:
-        TYPE m_type;
         value_t m_value;
 
     public:
-        JObject()
+        // 与 std::pmr 容器相同，list 与 dict 构造元素时传入自己的分配器（uses-allocator 构造）
+        using allocator_type = str_t::allocator_type;
+
+        // 默认为 null 类型
+        JObject() = default;
+
+        explicit JObject(const allocator_type &) {}
+
+        // 与 std::pmr 容器的拷贝构造相同，拷贝到默认的 memory_resource 上，
+        // 因此 arena 上的树的拷贝可以比 arena 活得更久
+        JObject(const JObject &other) : JObject(other, allocator_type()) {}
+
+        // 与 other 共享已在 allocator 上的 list 与 dict，其余的拷贝这一层到 allocator 上
+        JObject(const JObject &other, const allocator_type &allocator) : m_value(other.share(allocator.resource())) {}
+
+        // 被移动后的对象为 null，不会留下空的 list_ptr、dict_ptr
+        JObject(JObject &&other) noexcept : m_value(std::move(other.m_value))
+        {
+            other.m_value = null_t();
+        }
+
+        // 容器不在 allocator 上时拷贝过去，与 std::pmr 容器分配器不同时的移动相同
+        JObject(JObject &&other, const allocator_type &allocator)
+        {
+            if (str_t *str = get_if<str_t>(&other.m_value))
+            {
+                this->m_value.emplace<str_t>(std::move(*str), allocator);
+            }
+            else if (other.resource() == nullptr || other.resource() == allocator.resource())
+            {
+                this->m_value = std::move(other.m_value);
+            }
+            else
+            {
+                this->m_value = other.share(allocator.resource());
+            }
+            other.m_value = null_t();
+        }
+
+        // 不知道自己所在容器的分配器，与拷贝构造相同，拷贝到默认的 memory_resource 上
+        JObject &operator=(const JObject &other)
         {
-            // 默认为 null 类型
-            this->Null();
+            if (this != &other)
+            {
+                this->replace(other.share(std::pmr::get_default_resource()));
+            }
+            return *this;
+        }
+
+        // other 可能是自己的子节点，先移出再替换
+        JObject &operator=(JObject &&other) noexcept
+        {
+            if (this != &other)
+            {
+                value_t value(std::move(other.m_value));
+                other.m_value = null_t();
+                this->replace(std::move(value));
+            }
+            return *this;
         }
 
         JObject(int_t value)
@@ -90,9 +526,20 @@ namespace json
             Double(value);
         }
 
-        JObject(str_t const &value)
+        JObject(str_t value)
+        {
+            Str(std::move(value));
+        }
+
+        JObject(string_view value)
+        {
+            Str(str_t(value));
+        }
+
+        // 没有这个重载时字符串字面量会优先转换为 bool
+        JObject(const char *value)
         {
-            Str(value);
+            Str(str_t(value));
         }
 
         JObject(list_t value)
@@ -107,54 +554,48 @@ namespace json
 
         void Null()
         {
-            this->m_value = "null";
-            this->m_type = T_NULL;
+            this->m_value = null_t();
         }
 
         void Int(int_t value)
         {
             this->m_value = value;
-            this->m_type = T_INT;
         }
 
         void Bool(bool_t value)
         {
             this->m_value = value;
-            this->m_type = T_BOOL;
         }
 
         void Double(double_t value)
         {
             this->m_value = value;
-            this->m_type = T_DOUBLE;
         }
 
+        // 按值传入后移动，调用方传右值时整个过程不拷贝
         void Str(str_t value)
         {
-            this->m_value = value;
-            this->m_type = T_STR;
+            this->replace(std::move(value));
         }
 
         void List(list_t value)
         {
-            this->m_value = value;
-            this->m_type = T_LIST;
+            this->replace(make_list(std::move(value)));
         }
 
         void Dict(dict_t value)
         {
-            this->m_value = value;
-            this->m_type = T_DICT;
+            this->replace(make_dict(std::move(value)));
         }
 
         operator string()
         {
-            return Value<string>();
+            return string(Value<str_t>());
         }
 
         operator int()
         {
-            return Value<int>();
+            return int(Value<int_t>());
         }
 
         operator bool()
@@ -167,80 +608,74 @@ namespace json
             return Value<double>();
         }
 
-#define THROW_GET_ERROR(erron) throw std::logic_error("type error in get " #erron " value!")
-
+        // 类型不符时抛出异常，共享的 list 与 dict 先拷贝一份，修改不会影响其他 JObject；
+        // 返回的引用在之后拷贝这个 JObject 时仍然只指向自己的这一份
         template <class V>
         V &Value()
         {
-            // 安全类型检查
-            if constexpr (IS_TYPE(V, str_t))
-            {
-                if (this->m_type != T_STR)
-                {
-                    THROW_GET_ERROR(string);
-                }
-            }
-            else if constexpr (IS_TYPE(V, bool_t))
-            {
-                if (this->m_type != T_BOOL)
-                {
-                    THROW_GET_ERROR(BOOL);
-                }
-            }
-            else if constexpr (IS_TYPE(V, int_t))
-            {
-                if (this->m_type != T_INT)
-                {
-                    THROW_GET_ERROR(INT);
-                }
-            }
-            else if constexpr (IS_TYPE(V, double_t))
+            V &value = this->unshared<V>();
+            if constexpr (IS_TYPE(V, list_t) || IS_TYPE(V, dict_t))
             {
-                if (this->m_type != T_DOUBLE)
-                {
-                    THROW_GET_ERROR(DOUBLE);
-                }
+                this->leak();
             }
-            else if constexpr (IS_TYPE(V, list_t))
+            return value;
+        }
+
+        // 只读，不会拷贝共享的 list 与 dict
+        template <class V>
+        const V &Value() const
+        {
+            const V *v;
+            if constexpr (IS_TYPE(V, list_t))
             {
-                if (this->m_type != T_LIST)
-                {
-                    THROW_GET_ERROR(LIST);
-                }
+                const list_ptr *list = get_if<list_ptr>(&this->m_value);
+                v = list != nullptr ? &(*list)->value : nullptr;
             }
             else if constexpr (IS_TYPE(V, dict_t))
             {
-                if (this->m_type != T_DICT)
-                {
-                    THROW_GET_ERROR(DICT);
-                }
+                const dict_ptr *dict = get_if<dict_ptr>(&this->m_value);
+                v = dict != nullptr ? &(*dict)->value : nullptr;
             }
             else
             {
+                v = get_if<V>(&this->m_value);
             }
 
-            void *v = value();
             if (v == nullptr)
             {
-                throw std::logic_error("unknown type in JObject::Value()");
+                throw std::logic_error("type error in JObject::Value()");
             }
-
-            return *((V *)v);
+            return *v;
         }
 
-        TYPE Type()
+        TYPE Type() const
         {
-            return this->m_type;
+            return TYPE(this->m_value.index());
         }
 
-        string to_string();
+        // 序列化为紧凑的 json 字符串
+        string to_string() const;
+
+        // 统计整棵树的节点数与占用的内存，共享的子树每出现一次计算一次
+        MemoryUsage memory_usage() const;
+
+        // 深拷贝到 resource 上，不与原来的树共享，用于把 arena 上的值留到 arena 释放之后
+        JObject clone(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+
+        // 深比较，数字按数值比较（1 与 1.0 相等），共享同一个容器时直接相等
+        bool operator==(const JObject &other) const;
+
+        bool operator!=(const JObject &other) const
+        {
+            return !(*this == other);
+        }
 
         void push_back(JObject item)
         {
             // 判断是否是 list 类型
-            if (this->m_type == T_LIST)
+            if (this->Type() == T_LIST)
             {
-                auto &list = Value<list_t>();
+                auto &list = unshared<list_t>();
                 list.push_back(std::move(item));
                 return;
             }
@@ -250,27 +685,132 @@ namespace json
         void pop_back()
         {
             // 判断是否是 list 类型
-            if (this->m_type == T_LIST)
+            if (this->Type() == T_LIST)
             {
-                auto &list = Value<list_t>();
+                auto &list = unshared<list_t>();
                 list.pop_back();
                 return;
             }
             throw std::logic_error("not list type! JObject::pop_back()");
         }
 
-        JObject &operator[](string const &key)
+        // key 不存在时插入 null，只有插入时才构造 string
+        JObject &operator[](string_view key)
         {
             // 判断是否是 dict 类型
-            if (this->m_type == T_DICT)
+            if (this->Type() == T_DICT)
             {
-                auto &dict = Value<dict_t>();
-                return dict[key];
+                return Value<dict_t>()[key];
             }
             throw std::logic_error("not dict type! JObject::opertor[]()");
         }
+
+        // 字符串字面量精确匹配这个重载，不会与 operator int() 之后的内置下标产生歧义
+        JObject &operator[](const char *key)
+        {
+            return (*this)[string_view(key)];
+        }
+
+        // 查找 key，不存在时返回 nullptr，不会插入
+        JObject *find(string_view key)
+        {
+            if (this->Type() == T_DICT)
+            {
+                auto &dict = Value<dict_t>();
+                auto it = dict.find(key);
+                return it == dict.end() ? nullptr : &it->second;
+            }
+            throw std::logic_error("not dict type! JObject::find()");
+        }
+
+        const JObject *find(string_view key) const
+        {
+            // 判断是否是 dict 类型
+            if (this->Type() == T_DICT)
+            {
+                auto &dict = Value<dict_t>();
+                auto it = dict.find(key);
+                return it == dict.end() ? nullptr : &it->second;
+            }
+            throw std::logic_error("not dict type! JObject::find()");
+        }
+
+        // 查找 key，不存在时抛出异常
+        JObject &at(string_view key)
+        {
+            JObject *item = this->find(key);
+            if (item == nullptr)
+            {
+                throw std::logic_error("key not found! JObject::at()");
+            }
+            return *item;
+        }
+
+        const JObject &at(string_view key) const
+        {
+            const JObject *item = this->find(key);
+            if (item == nullptr)
+            {
+                throw std::logic_error("key not found! JObject::at()");
+            }
+            return *item;
+        }
+
+        bool contains(string_view key) const
+        {
+            return this->find(key) != nullptr;
+        }
     };
 
+    // 这些函数会实例化 map_t 的成员，要在 JObject 定义之后
+    inline ChunkedDict::allocator_type ChunkedDict::get_allocator() const
+    {
+        if (const map_t *map = get_if<map_t>(&this->m_items))
+        {
+            return map->get_allocator();
+        }
+        return allocator_type(std::get<Chunks>(this->m_items).list.get_allocator().resource());
+    }
+
+    inline ChunkedDict::size_type ChunkedDict::size() const
+    {
+        if (const map_t *map = get_if<map_t>(&this->m_items))
+        {
+            return map->size();
+        }
+        return std::get<Chunks>(this->m_items).size;
+    }
+
+    inline size_t ChunkedDict::chunk_count() const
+    {
+        if (const map_t *map = get_if<map_t>(&this->m_items))
+        {
+            return map->empty() ? 0 : 1;
+        }
+        return std::get<Chunks>(this->m_items).list.size();
+    }
+
+    inline void ChunkedDict::leak(size_t index)
+    {
+        if (Chunks *chunks = get_if<Chunks>(&this->m_items))
+        {
+            chunks->list[index]->leaked = true;
+        }
+        else
+        {
+            this->m_leaked = true;
+        }
+    }
+
+    inline const ChunkedDict::map_t &ChunkedDict::chunk(size_t index) const
+    {
+        if (const map_t *map = get_if<map_t>(&this->m_items))
+        {
+            return *map;
+        }
+        return std::get<Chunks>(this->m_items).list[index]->map;
+    }
+
 }
 
 #endif // MYUTIL_JOBJECT_H
\ No newline at end of file
@@ -0,0 +1,584 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <thread>
+#include "Parser.h"
+
+namespace json
+{
+    JObject Parser::fromString(string_view content, std::pmr::memory_resource *resource)
+    {
+        Parser parser;
+        parser.m_str = content;
+        parser.m_idx = 0;
+        parser.m_resource = resource;
+
+        JObject result = parser.parse();
+        // 值之后只允许有空白
+        if (parser.get_next_token() != 0)
+        {
+            parser.error("unexpected content after value");
+        }
+        return result;
+    }
+
+    // 只区分字符串内外与嵌套深度地扫描顶层数组，open 为 '[' 的位置
+    // 在每个目标位置之后的第一个顶层逗号处切分，bounds 记录 '['、各个切分处的 ',' 以及 ']' 的位置
+    // 扫描不到匹配的 ']' 时返回 false
+    static bool split_top_level(string_view content, size_t open, size_t parts, vector<size_t> &bounds)
+    {
+        bounds.assign(1, open);
+        size_t part_size = (content.size() - open) / parts;
+        size_t target = open + part_size;
+        size_t depth = 0;
+        for (size_t i = open; i < content.size(); i++)
+        {
+            switch (content[i])
+            {
+            case '\"':
+                // 跳到字符串结尾，转义字符连同下一个字符一起跳过
+                for (i++; i < content.size() && content[i] != '\"'; i++)
+                {
+                    if (content[i] == '\\')
+                    {
+                        i++;
+                    }
+                }
+                break;
+            case '[':
+            case '{':
+                depth++;
+                break;
+            case ']':
+            case '}':
+                if (--depth == 0)
+                {
+                    bounds.push_back(i);
+                    return true;
+                }
+                break;
+            case ',':
+                if (depth == 1 && i >= target && bounds.size() < parts)
+                {
+                    bounds.push_back(i);
+                    target = i + part_size;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        return false;
+    }
+
+    JObject Parser::fromStringParallel(string_view content, size_t threads, size_t min_chunk)
+    {
+        if (threads == 0)
+        {
+            threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        size_t parts = std::min(threads, content.size() / std::max<size_t>(1, min_chunk));
+
+        Parser scanner;
+        scanner.m_str = content;
+        vector<size_t> bounds;
+        if (parts <= 1 || scanner.get_next_token() != '[' || !split_top_level(content, scanner.m_idx, parts, bounds))
+        {
+            return fromString(content);
+        }
+        // 数组以 ']' 结束，之后只允许有空白
+        scanner.m_idx = bounds.back() + 1;
+        if (content[bounds.back()] != ']' || scanner.get_next_token() != 0)
+        {
+            return fromString(content);
+        }
+
+        // 每一段解析到各自的 list_t，第一段在当前线程中解析
+        size_t chunks = bounds.size() - 1;
+        vector<list_t> lists(chunks);
+        vector<std::exception_ptr> errors(chunks);
+        auto work = [&](size_t chunk)
+        {
+            try
+            {
+                Parser parser;
+                parser.m_str = content;
+                parser.m_idx = bounds[chunk] + 1;
+                // 与串行解析一样计入顶层数组的深度
+                parser.m_depth = 1;
+                // 只有紧跟 '[' 的第一段可以为空，逗号之后必须有值
+                if (chunk == 0 && parser.get_next_token() == ']')
+                {
+                    return;
+                }
+                parser.parse_elements(bounds[chunk + 1], lists[chunk]);
+            }
+            catch (...)
+            {
+                errors[chunk] = std::current_exception();
+            }
+        };
+        vector<std::thread> workers;
+        for (size_t chunk = 1; chunk < chunks; chunk++)
+        {
+            workers.emplace_back(work, chunk);
+        }
+        work(0);
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        // 出错时重新串行解析，报出与 fromString 相同的错误
+        for (auto &error : errors)
+        {
+            if (error)
+            {
+                return fromString(content);
+            }
+        }
+
+        size_t total = 0;
+        for (auto &list : lists)
+        {
+            total += list.size();
+        }
+        list_t result = std::move(lists[0]);
+        result.reserve(total);
+        for (size_t chunk = 1; chunk < chunks; chunk++)
+        {
+            std::move(lists[chunk].begin(), lists[chunk].end(), std::back_inserter(result));
+        }
+        return JObject(std::move(result));
+    }
+
+    void Parser::parse_elements(size_t end, list_t &list)
+    {
+        while (true)
+        {
+            list.push_back(this->parse());
+            char token = this->get_next_token();
+            if (this->m_idx == end)
+            {
+                return;
+            }
+            if (token != ',' || this->m_idx > end)
+            {
+                this->error("expected ',' or ']' in list");
+            }
+            this->m_idx++;
+        }
+    }
+
+    char Parser::get_next_token()
+    {
+        while (this->m_idx < this->m_str.size())
+        {
+            char c = this->m_str[this->m_idx];
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+            {
+                return c;
+            }
+            this->m_idx++;
+        }
+        return 0;
+    }
+
+    JObject Parser::parse()
+    {
+        char token = this->get_next_token();
+        switch (token)
+        {
+        case 'n':
+            return this->parse_null();
+        case 't':
+        case 'f':
+            return this->parse_bool();
+        case '\"':
+            return JObject(this->parse_string());
+        case '[':
+            return this->parse_list();
+        case '{':
+            return this->parse_dict();
+        default:
+            if (token == '-' || (token >= '0' && token <= '9'))
+            {
+                return this->parse_number();
+            }
+            this->error(token == 0 ? "unexpected end of content" : "unexpected character");
+        }
+    }
+
+    JObject Parser::parse_null()
+    {
+        if (this->m_str.compare(this->m_idx, 4, "null") != 0)
+        {
+            this->error("parse null error");
+        }
+        this->m_idx += 4;
+        return JObject();
+    }
+
+    JObject Parser::parse_bool()
+    {
+        if (this->m_str.compare(this->m_idx, 4, "true") == 0)
+        {
+            this->m_idx += 4;
+            return JObject(true);
+        }
+        if (this->m_str.compare(this->m_idx, 5, "false") == 0)
+        {
+            this->m_idx += 5;
+            return JObject(false);
+        }
+        this->error("parse bool error");
+    }
+
+    JObject Parser::parse_number()
+    {
+        // 先按 json 语法确定数字的范围，再决定按整数还是小数解析
+        size_t begin = this->m_idx;
+        size_t pos = begin;
+        auto digits = [&]()
+        {
+            size_t start = pos;
+            while (pos < this->m_str.size() && this->m_str[pos] >= '0' && this->m_str[pos] <= '9')
+            {
+                pos++;
+            }
+            return pos - start;
+        };
+
+        if (this->m_str[pos] == '-')
+        {
+            pos++;
+        }
+        size_t integer_begin = pos;
+        if (digits() == 0 || (this->m_str[integer_begin] == '0' && pos - integer_begin > 1))
+        {
+            this->error("parse number error");
+        }
+        bool is_double = false;
+        if (pos < this->m_str.size() && this->m_str[pos] == '.')
+        {
+            pos++;
+            is_double = true;
+            if (digits() == 0)
+            {
+                this->error("parse number error");
+            }
+        }
+        if (pos < this->m_str.size() && (this->m_str[pos] == 'e' || this->m_str[pos] == 'E'))
+        {
+            pos++;
+            is_double = true;
+            if (pos < this->m_str.size() && (this->m_str[pos] == '+' || this->m_str[pos] == '-'))
+            {
+                pos++;
+            }
+            if (digits() == 0)
+            {
+                this->error("parse number error");
+            }
+        }
+        this->m_idx = pos;
+
+        // 整数在 int64 范围内直接累加，溢出时按小数处理
+        if (!is_double)
+        {
+            bool negative = this->m_str[begin] == '-';
+            uint64_t value = 0;
+            bool overflow = false;
+            for (size_t i = integer_begin; i < pos; i++)
+            {
+                uint64_t digit = uint64_t(this->m_str[i] - '0');
+                if (value > (uint64_t(INT64_MAX) + 1 - digit) / 10)
+                {
+                    overflow = true;
+                    break;
+                }
+                value = value * 10 + digit;
+            }
+            // -0 没有对应的整数，按小数保存以保留符号
+            if (!overflow && (negative ? value != 0 : value <= uint64_t(INT64_MAX)))
+            {
+                return JObject(int_t(negative ? 0 - value : value));
+            }
+        }
+
+        const char *first = this->m_str.data() + begin;
+        size_t length = pos - begin;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        // 直接在输入上解析，不分配内存，也不受 locale 的小数点影响
+        double_t value;
+        auto result = std::from_chars(first, first + length, value);
+        if (result.ec == std::errc())
+        {
+            return JObject(value);
+        }
+        // 超出 double 范围时 from_chars 不给出结果，交给 strtod 得到 inf 或 0
+        string copy(first, length);
+        return JObject(double_t(std::strtod(copy.c_str(), nullptr)));
+#else
+        // strtod 需要以 '\0' 结尾的字符串，数字很短，拷贝到栈上
+        char buffer[64];
+        if (length >= sizeof(buffer))
+        {
+            string copy(first, length);
+            return JObject(double_t(std::strtod(copy.c_str(), nullptr)));
+        }
+        memcpy(buffer, first, length);
+        buffer[length] = '\0';
+        return JObject(double_t(std::strtod(buffer, nullptr)));
+#endif
+    }
+
+    // 读取 4 位十六进制数字
+    static bool read_hex4(string_view str, size_t pos, uint32_t &code)
+    {
+        if (pos + 4 > str.size())
+        {
+            return false;
+        }
+        code = 0;
+        for (size_t i = pos; i < pos + 4; i++)
+        {
+            char c = str[i];
+            code <<= 4;
+            if (c >= '0' && c <= '9')
+            {
+                code |= uint32_t(c - '0');
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                code |= uint32_t(c - 'a' + 10);
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                code |= uint32_t(c - 'A' + 10);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 把码点编码为 UTF-8
+    static void append_utf8(str_t &out, uint32_t code)
+    {
+        if (code < 0x80)
+        {
+            out.push_back(char(code));
+        }
+        else if (code < 0x800)
+        {
+            out.push_back(char(0xC0 | (code >> 6)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        }
+        else if (code < 0x10000)
+        {
+            out.push_back(char(0xE0 | (code >> 12)));
+            out.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        }
+        else
+        {
+            out.push_back(char(0xF0 | (code >> 18)));
+            out.push_back(char(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        }
+    }
+
+    str_t Parser::parse_string()
+    {
+        // 跳过开头的 "
+        this->m_idx++;
+        str_t result(this->m_resource);
+        while (true)
+        {
+            // 不含转义字符的一段整体追加
+            size_t run = this->m_idx;
+            while (this->m_idx < this->m_str.size() && this->m_str[this->m_idx] != '\"' &&
+                   this->m_str[this->m_idx] != '\\' && (unsigned char)this->m_str[this->m_idx] >= 0x20)
+            {
+                this->m_idx++;
+            }
+            result.append(this->m_str.data() + run, this->m_idx - run);
+
+            if (this->m_idx >= this->m_str.size())
+            {
+                this->error("missing closing quote in string");
+            }
+            char c = this->m_str[this->m_idx];
+            if (c == '\"')
+            {
+                this->m_idx++;
+                return result;
+            }
+            if (c != '\\')
+            {
+                this->error("control character in string");
+            }
+            if (this->m_idx + 1 >= this->m_str.size())
+            {
+                this->error("missing closing quote in string");
+            }
+
+            char escape = this->m_str[this->m_idx + 1];
+            this->m_idx += 2;
+            switch (escape)
+            {
+            case '\"':
+            case '\\':
+            case '/':
+                result.push_back(escape);
+                break;
+            case 'b':
+                result.push_back('\b');
+                break;
+            case 'f':
+                result.push_back('\f');
+                break;
+            case 'n':
+                result.push_back('\n');
+                break;
+            case 'r':
+                result.push_back('\r');
+                break;
+            case 't':
+                result.push_back('\t');
+                break;
+            case 'u':
+            {
+                uint32_t code;
+                if (!read_hex4(this->m_str, this->m_idx, code))
+                {
+                    this->error("bad unicode escape in string");
+                }
+                this->m_idx += 4;
+                // 代理对合并为一个码点
+                if (code >= 0xD800 && code <= 0xDBFF)
+                {
+                    uint32_t low;
+                    if (this->m_str.compare(this->m_idx, 2, "\\u") != 0 || !read_hex4(this->m_str, this->m_idx + 2, low) ||
+                        low < 0xDC00 || low > 0xDFFF)
+                    {
+                        this->error("lone surrogate in string");
+                    }
+                    this->m_idx += 6;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                else if (code >= 0xDC00 && code <= 0xDFFF)
+                {
+                    this->error("lone surrogate in string");
+                }
+                append_utf8(result, code);
+                break;
+            }
+            default:
+                this->error("bad escape in string");
+            }
+        }
+    }
+
+    JObject Parser::parse_list()
+    {
+        if (++this->m_depth > MAX_DEPTH)
+        {
+            this->error("exceeded max nesting depth");
+        }
+        // 跳过 [
+        this->m_idx++;
+        list_t list(this->m_resource);
+        if (this->get_next_token() == ']')
+        {
+            this->m_idx++;
+            this->m_depth--;
+            return JObject(std::move(list));
+        }
+
+        while (true)
+        {
+            // 解析结果是右值，直接移动进 list
+            list.push_back(this->parse());
+
+            char token = this->get_next_token();
+            this->m_idx++;
+            if (token == ']')
+            {
+                break;
+            }
+            if (token != ',')
+            {
+                this->error("expected ',' or ']' in list");
+            }
+        }
+        this->m_depth--;
+        return JObject(std::move(list));
+    }
+
+    JObject Parser::parse_dict()
+    {
+        if (++this->m_depth > MAX_DEPTH)
+        {
+            this->error("exceeded max nesting depth");
+        }
+        // 跳过 {
+        this->m_idx++;
+        dict_t dict(this->m_resource);
+        if (this->get_next_token() == '}')
+        {
+            this->m_idx++;
+            this->m_depth--;
+            return JObject(std::move(dict));
+        }
+
+        while (true)
+        {
+            if (this->get_next_token() != '\"')
+            {
+                this->error("key must be string in dict");
+            }
+            str_t key = this->parse_string();
+            if (this->get_next_token() != ':')
+            {
+                this->error("expected ':' in dict");
+            }
+            this->m_idx++;
+
+            // key 与值都移动进 dict，重复的 key 以后者为准
+            dict.insert_or_assign(std::move(key), this->parse());
+
+            char token = this->get_next_token();
+            this->m_idx++;
+            if (token == '}')
+            {
+                break;
+            }
+            if (token != ',')
+            {
+                this->error("expected ',' or '}' in dict");
+            }
+        }
+        this->m_depth--;
+        return JObject(std::move(dict));
+    }
+
+    void Parser::expect(char token, const char *message)
+    {
+        if (this->get_next_token() != token)
+        {
+            this->error(message);
+        }
+    }
+
+    void Parser::error(const char *message)
+    {
+        throw std::logic_error(string(message) + " at position " + std::to_string(this->m_idx));
+    }
+}
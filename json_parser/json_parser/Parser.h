@@ -1,59 +1,590 @@
 #ifndef MYUTIL_PARSER_H
 #define MYUTIL_PARSER_H
 
+#include <charconv>
+#include <limits>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <sstream>
+#include <type_traits>
+#include "JObject.h"
+#include "../../magic_template/scienum.h"
 
 namespace json
 {
-#define FUNC_TO_NAME _to_json
-#define FUNC_FROM_NAME _from_json
+    // 在结构体中用 JSON_FIELDS(a, b, c) 声明一次需要序列化的字段，
+    // 生成的 FUNC_FIELDS_NAME 依次以 (字段名, 字段) 调用 visitor，供 toJson/fromJson 使用
+#define FUNC_FIELDS_NAME _json_fields
 
-#define START_TO_JSONvoid            \
-    FUNC_TO_NAME(json::JObject &obj) \
-    const                            \
-    {
-#define to(key) obj[key]
-// push 一个自定义类型的成员
-#define to_struct(key, struct_member)    \
-    json::JObject tmp((json::dict_t())); \
-    struct_member.FUNC_TO_NAME(tmp);     \
-    obj[key] = tmp
-#define END_TO_JSON }
+#define JSON_FIELDS(...)                                    \
+    using _json_fields_tag = void;                          \
+    template <class Visitor>                                \
+    void FUNC_FIELDS_NAME(Visitor &&visitor)                \
+    {                                                       \
+        JSON_FOR_EACH(JSON_VISIT_FIELD, __VA_ARGS__)        \
+    }                                                       \
+    template <class Visitor>                                \
+    void FUNC_FIELDS_NAME(Visitor &&visitor) const          \
+    {                                                       \
+        JSON_FOR_EACH(JSON_VISIT_FIELD, __VA_ARGS__)        \
+    }
 
-#define START_FROM_JSON                     \
-    void FUNC_FROM_NAME(json::JObejct &obj) \
-    {
-#define from(key, type) obj[key].Value<type>()
-#define from_struct(key, struct_member) struct_member.FUNC_FROM_NAME(obj[key])
-#define END_FROM_JSON }
+#define JSON_VISIT_FIELD(field) visitor(#field, this->field);
+
+// 对每个参数调用 f，最多 32 个；JSON_EXPAND 用于 MSVC 展开 __VA_ARGS__
+#define JSON_EXPAND(x) x
+#define JSON_FOR_EACH_1(f, x) f(x)
+#define JSON_FOR_EACH_2(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_1(f, __VA_ARGS__))
+#define JSON_FOR_EACH_3(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_2(f, __VA_ARGS__))
+#define JSON_FOR_EACH_4(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_3(f, __VA_ARGS__))
+#define JSON_FOR_EACH_5(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_4(f, __VA_ARGS__))
+#define JSON_FOR_EACH_6(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_5(f, __VA_ARGS__))
+#define JSON_FOR_EACH_7(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_6(f, __VA_ARGS__))
+#define JSON_FOR_EACH_8(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_7(f, __VA_ARGS__))
+#define JSON_FOR_EACH_9(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_8(f, __VA_ARGS__))
+#define JSON_FOR_EACH_10(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_9(f, __VA_ARGS__))
+#define JSON_FOR_EACH_11(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_10(f, __VA_ARGS__))
+#define JSON_FOR_EACH_12(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_11(f, __VA_ARGS__))
+#define JSON_FOR_EACH_13(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_12(f, __VA_ARGS__))
+#define JSON_FOR_EACH_14(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_13(f, __VA_ARGS__))
+#define JSON_FOR_EACH_15(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_14(f, __VA_ARGS__))
+#define JSON_FOR_EACH_16(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_15(f, __VA_ARGS__))
+#define JSON_FOR_EACH_17(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_16(f, __VA_ARGS__))
+#define JSON_FOR_EACH_18(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_17(f, __VA_ARGS__))
+#define JSON_FOR_EACH_19(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_18(f, __VA_ARGS__))
+#define JSON_FOR_EACH_20(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_19(f, __VA_ARGS__))
+#define JSON_FOR_EACH_21(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_20(f, __VA_ARGS__))
+#define JSON_FOR_EACH_22(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_21(f, __VA_ARGS__))
+#define JSON_FOR_EACH_23(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_22(f, __VA_ARGS__))
+#define JSON_FOR_EACH_24(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_23(f, __VA_ARGS__))
+#define JSON_FOR_EACH_25(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_24(f, __VA_ARGS__))
+#define JSON_FOR_EACH_26(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_25(f, __VA_ARGS__))
+#define JSON_FOR_EACH_27(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_26(f, __VA_ARGS__))
+#define JSON_FOR_EACH_28(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_27(f, __VA_ARGS__))
+#define JSON_FOR_EACH_29(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_28(f, __VA_ARGS__))
+#define JSON_FOR_EACH_30(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_29(f, __VA_ARGS__))
+#define JSON_FOR_EACH_31(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_30(f, __VA_ARGS__))
+#define JSON_FOR_EACH_32(f, x, ...) f(x) JSON_EXPAND(JSON_FOR_EACH_31(f, __VA_ARGS__))
+#define JSON_GET_MACRO(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, NAME, ...) NAME
+#define JSON_FOR_EACH(f, ...) \
+    JSON_EXPAND(JSON_GET_MACRO(__VA_ARGS__, JSON_FOR_EACH_32, JSON_FOR_EACH_31, JSON_FOR_EACH_30, JSON_FOR_EACH_29, JSON_FOR_EACH_28, JSON_FOR_EACH_27, JSON_FOR_EACH_26, JSON_FOR_EACH_25, JSON_FOR_EACH_24, JSON_FOR_EACH_23, JSON_FOR_EACH_22, JSON_FOR_EACH_21, JSON_FOR_EACH_20, JSON_FOR_EACH_19, JSON_FOR_EACH_18, JSON_FOR_EACH_17, JSON_FOR_EACH_16, JSON_FOR_EACH_15, JSON_FOR_EACH_14, JSON_FOR_EACH_13, JSON_FOR_EACH_12, JSON_FOR_EACH_11, JSON_FOR_EACH_10, JSON_FOR_EACH_9, JSON_FOR_EACH_8, JSON_FOR_EACH_7, JSON_FOR_EACH_6, JSON_FOR_EACH_5, JSON_FOR_EACH_4, JSON_FOR_EACH_3, JSON_FOR_EACH_2, JSON_FOR_EACH_1)(f, __VA_ARGS__))
 
     using std::string;
     using std::string_view;
     using std::stringstream;
 
-    class JObject;
+    // 用 JSON_FIELDS 声明了字段的结构体
+    template <class T, class = void>
+    struct is_reflected : std::false_type
+    {
+    };
+
+    template <class T>
+    struct is_reflected<T, std::void_t<typename T::_json_fields_tag>> : std::true_type
+    {
+    };
+
+    template <class T>
+    struct is_optional : std::false_type
+    {
+    };
+
+    template <class T>
+    struct is_optional<std::optional<T>> : std::true_type
+    {
+    };
+
+    // string 或 str_t
+    template <class T>
+    constexpr bool is_string = IS_TYPE(T, string) || IS_TYPE(T, str_t);
+
+    // key 为 string 的 map、unordered_map，对应 dict
+    template <class T, class = void>
+    struct is_map : std::false_type
+    {
+    };
+
+    template <class T>
+    struct is_map<T, std::void_t<typename T::key_type, typename T::mapped_type>> : std::bool_constant<is_string<typename T::key_type>>
+    {
+    };
+
+    // vector、deque、list 等可以 push_back 的容器，对应 list
+    template <class T, class = void>
+    struct is_sequence : std::false_type
+    {
+    };
+
+    template <class T>
+    struct is_sequence<T, std::void_t<typename T::value_type,
+                                      decltype(std::declval<T &>().push_back(std::declval<typename T::value_type>()))>>
+        : std::bool_constant<!is_string<T>>
+    {
+    };
+
+    template <class T>
+    constexpr bool always_false = false;
+
+    // 枚举值 0 ~ 256 的名字，由 scienum 取得，每个枚举类型只计算一次，没有名字的值为空
+    // 底层类型更窄时只到它的最大值，例如 uint8_t 为 0 ~ 255
+    template <class E>
+    const vector<string> &enum_names()
+    {
+        static const vector<string> names = []()
+        {
+            constexpr int end = scienum::enum_scan_end<E>();
+            vector<string> names(end + 1);
+            for (int i = 0; i <= end; i++)
+            {
+                string name = scienum::get_enum_name((E)i);
+                name = name.substr(name.rfind(':') == string::npos ? 0 : name.rfind(':') + 1);
+                // 没有对应枚举项时得到的是 (E)5 这样的表达式
+                bool valid = !name.empty() && !(name[0] >= '0' && name[0] <= '9');
+                for (char c : name)
+                {
+                    valid = valid && (c == '_' || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'));
+                }
+                if (valid)
+                {
+                    names[i] = std::move(name);
+                }
+            }
+            return names;
+        }();
+        return names;
+    }
 
     class Parser
     {
     private:
-        string m_str;
+        // 只在一次 fromString() 期间使用，不拷贝输入
+        string_view m_str;
         size_t m_idx{};
+        // 当前嵌套深度
+        size_t m_depth{};
+        // 字符串与容器都在这里分配
+        std::pmr::memory_resource *m_resource = std::pmr::get_default_resource();
+
+        // 最大嵌套深度，递归下降解析，防止栈溢出
+        static constexpr size_t MAX_DEPTH = 512;
+
+        // 跳过空白，返回下一个字符，到达结尾时返回 0
+        char get_next_token();
+
+        // 解析一个值
+        JObject parse();
+
+        JObject parse_null();
+
+        JObject parse_bool();
+
+        JObject parse_number();
+
+        // 解析字符串，处理转义字符，\uXXXX 转为 UTF-8
+        str_t parse_string();
+
+        // 元素逐个移动进 list_t，整个 list_t 再移动进 JObject
+        JObject parse_list();
+
+        JObject parse_dict();
+
+        // 解析以逗号分隔的数组元素直到 end 处，追加到 list 中，end 处为顶层的 ',' 或 ']'
+        void parse_elements(size_t end, list_t &list);
+
+        // 下一个字符必须是 token，否则报错
+        void expect(char token, const char *message);
+
+        // 抛出带位置的错误
+        [[noreturn]] void error(const char *message);
+
+        // 逐个元素调用 on_item 读取 [...]
+        template <class F>
+        void read_list(F &&on_item)
+        {
+            this->expect('[', "expected list");
+            if (++this->m_depth > MAX_DEPTH)
+            {
+                this->error("exceeded max nesting depth");
+            }
+            this->m_idx++;
+            if (this->get_next_token() == ']')
+            {
+                this->m_idx++;
+                this->m_depth--;
+                return;
+            }
+            while (true)
+            {
+                on_item();
+                char token = this->get_next_token();
+                this->m_idx++;
+                if (token == ']')
+                {
+                    break;
+                }
+                if (token != ',')
+                {
+                    this->error("expected ',' or ']' in list");
+                }
+            }
+            this->m_depth--;
+        }
+
+        // 逐个成员以 key 调用 on_member 读取 {...}，on_member 负责读取值
+        template <class F>
+        void read_dict(F &&on_member)
+        {
+            this->expect('{', "expected dict");
+            if (++this->m_depth > MAX_DEPTH)
+            {
+                this->error("exceeded max nesting depth");
+            }
+            this->m_idx++;
+            if (this->get_next_token() == '}')
+            {
+                this->m_idx++;
+                this->m_depth--;
+                return;
+            }
+            while (true)
+            {
+                this->expect('\"', "key must be string in dict");
+                str_t key = this->parse_string();
+                this->expect(':', "expected ':' in dict");
+                this->m_idx++;
+                on_member(std::move(key));
+                char token = this->get_next_token();
+                this->m_idx++;
+                if (token == '}')
+                {
+                    break;
+                }
+                if (token != ',')
+                {
+                    this->error("expected ',' or '}' in dict");
+                }
+            }
+            this->m_depth--;
+        }
+
+        // 直接解析到 dst 中，不构建 JObject 树
+        template <class T>
+        void read_value(T &dst)
+        {
+            char token = this->get_next_token();
+            if constexpr (IS_TYPE(T, JObject))
+            {
+                dst = this->parse();
+            }
+            else if constexpr (is_optional<T>::value)
+            {
+                if (token == 'n')
+                {
+                    this->parse_null();
+                    dst.reset();
+                }
+                else
+                {
+                    this->read_value(dst.emplace());
+                }
+            }
+            else if constexpr (IS_TYPE(T, bool))
+            {
+                if (token != 't' && token != 'f')
+                {
+                    this->error("expected bool");
+                }
+                dst = this->parse_bool().template Value<bool_t>();
+            }
+            else if constexpr (std::is_enum_v<T>)
+            {
+                // 按名字读取，也接受整数
+                if (token != '\"')
+                {
+                    std::underlying_type_t<T> value;
+                    this->read_value(value);
+                    dst = T(value);
+                    return;
+                }
+                str_t name = this->parse_string();
+                const vector<string> &names = enum_names<T>();
+                for (size_t i = 0; i < names.size(); i++)
+                {
+                    if (!names[i].empty() && names[i] == string_view(name))
+                    {
+                        dst = T(i);
+                        return;
+                    }
+                }
+                this->error("unknown enum name");
+            }
+            else if constexpr (std::is_arithmetic_v<T>)
+            {
+                if (token != '-' && !(token >= '0' && token <= '9'))
+                {
+                    this->error("expected number");
+                }
+                size_t begin = this->m_idx;
+                JObject number = this->parse_number();
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    dst = T(number.Type() == T_INT ? double_t(number.Value<int_t>()) : number.Value<double_t>());
+                }
+                else
+                {
+                    // 超出 int64 的整数被解析为小数，无符号类型再直接从数字读取，toJson 写出的 uint64 可以读回
+                    if (number.Type() != T_INT)
+                    {
+                        string_view text = this->m_str.substr(begin, this->m_idx - begin);
+                        bool negative = text[0] == '-';
+                        string_view digits = text.substr(negative ? 1 : 0);
+                        if (digits.find_first_not_of("0123456789") != string_view::npos)
+                        {
+                            this->error("expected integer");
+                        }
+                        uint64_t value = 0;
+                        auto result = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+                        // -0 同样按小数保存，读作 0
+                        bool zero = result.ec == std::errc() && value == 0;
+                        if (!zero && (!std::is_unsigned_v<T> || negative || result.ec != std::errc() || value > uint64_t(std::numeric_limits<T>::max())))
+                        {
+                            this->error("integer out of range");
+                        }
+                        dst = T(value);
+                        return;
+                    }
+                    int_t value = number.Value<int_t>();
+                    bool in_range = std::is_signed_v<T>
+                                        ? value >= int_t(std::numeric_limits<T>::min()) && value <= int_t(std::numeric_limits<T>::max())
+                                        : value >= 0 && uint64_t(value) <= uint64_t(std::numeric_limits<T>::max());
+                    if (!in_range)
+                    {
+                        this->error("integer out of range");
+                    }
+                    dst = T(value);
+                }
+            }
+            else if constexpr (is_string<T>)
+            {
+                this->expect('\"', "expected string");
+                if constexpr (IS_TYPE(T, str_t))
+                {
+                    dst = this->parse_string();
+                }
+                else
+                {
+                    str_t value = this->parse_string();
+                    dst.assign(value.data(), value.size());
+                }
+            }
+            else if constexpr (is_map<T>::value)
+            {
+                dst.clear();
+                this->read_dict([&](str_t key)
+                                {
+                                    typename T::mapped_type value{};
+                                    this->read_value(value);
+                                    if constexpr (IS_TYPE(typename T::key_type, str_t))
+                                    {
+                                        dst.insert_or_assign(std::move(key), std::move(value));
+                                    }
+                                    else
+                                    {
+                                        dst.insert_or_assign(typename T::key_type(key), std::move(value));
+                                    } });
+            }
+            else if constexpr (is_sequence<T>::value)
+            {
+                dst.clear();
+                this->read_list([&]()
+                                {
+                                    typename T::value_type item{};
+                                    this->read_value(item);
+                                    dst.push_back(std::move(item)); });
+            }
+            else if constexpr (is_reflected<T>::value)
+            {
+                // 未声明的 key 解析后丢弃，json 中没有的字段保持原值
+                this->read_dict([&](str_t key)
+                                {
+                                    bool found = false;
+                                    dst.FUNC_FIELDS_NAME([&](const char *name, auto &member)
+                                                         {
+                                                             if (!found && key == name)
+                                                             {
+                                                                 found = true;
+                                                                 this->read_value(member);
+                                                             } });
+                                    if (!found)
+                                    {
+                                        this->parse();
+                                    } });
+            }
+            else
+            {
+                static_assert(always_false<T>, "type can't be read from json");
+            }
+        }
+
+        // 直接写出 json 文本，不构建 JObject 树
+        template <class T>
+        static void write_value(string &out, T const &src)
+        {
+            if constexpr (IS_TYPE(T, JObject))
+            {
+                src.dump(out);
+            }
+            else if constexpr (is_optional<T>::value)
+            {
+                if (src.has_value())
+                {
+                    write_value(out, *src);
+                }
+                else
+                {
+                    out += "null";
+                }
+            }
+            else if constexpr (IS_TYPE(T, bool))
+            {
+                out += src ? "true" : "false";
+            }
+            else if constexpr (std::is_enum_v<T>)
+            {
+                // 有名字的值写出名字，否则写出整数
+                auto value = std::underlying_type_t<T>(src);
+                const vector<string> &names = enum_names<T>();
+                if (value >= 0 && uint64_t(value) < names.size() && !names[size_t(value)].empty())
+                {
+                    dump_string(out, names[size_t(value)]);
+                }
+                else
+                {
+                    write_value(out, value);
+                }
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                char buffer[24];
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), src);
+                out.append(buffer, result.ptr);
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                dump_double(out, double_t(src));
+            }
+            else if constexpr (std::is_convertible_v<T const &, string_view>)
+            {
+                dump_string(out, src);
+            }
+            else if constexpr (is_map<T>::value)
+            {
+                out.push_back('{');
+                bool first = true;
+                for (auto &[key, value] : src)
+                {
+                    if (!first)
+                    {
+                        out.push_back(',');
+                    }
+                    dump_string(out, key);
+                    out.push_back(':');
+                    write_value(out, value);
+                    first = false;
+                }
+                out.push_back('}');
+            }
+            else if constexpr (is_sequence<T>::value)
+            {
+                out.push_back('[');
+                bool first = true;
+                for (auto &&item : src)
+                {
+                    if (!first)
+                    {
+                        out.push_back(',');
+                    }
+                    // vector<bool> 的元素是代理对象，转为元素类型再写出
+                    write_value(out, static_cast<typename T::value_type const &>(item));
+                    first = false;
+                }
+                out.push_back(']');
+            }
+            else if constexpr (is_reflected<T>::value)
+            {
+                // 字段名是标识符，不需要转义
+                out.push_back('{');
+                bool first = true;
+                src.FUNC_FIELDS_NAME([&](const char *name, auto const &member)
+                                     {
+                                         if (!first)
+                                         {
+                                             out.push_back(',');
+                                         }
+                                         out.push_back('\"');
+                                         out += name;
+                                         out += "\":";
+                                         write_value(out, member);
+                                         first = false; });
+                out.push_back('}');
+            }
+            else
+            {
+                static_assert(always_false<T>, "type can't be written as json");
+            }
+        }
 
     public:
         Parser() = default;
 
-        static JObject fromString(string_view content);
+        // 解析 content 中的一个 json 值，之后只允许有空白
+        // 整棵树都分配在 resource 上，传入 monotonic_buffer_resource 时一次请求的内存可以整体释放，
+        // 此时 JObject 不能比 resource 活得更久，需要留下的部分用 JObject::clone() 深拷贝出来
+        static JObject fromString(string_view content, std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+        // 顶层为数组的大文档：先扫描出顶层的逗号，切分后多线程解析再按顺序拼接，结果与 fromString 相同
+        // threads 为 0 时使用硬件线程数，每段至少 min_chunk 字节，切不开时退化为 fromString
+        // 各个线程同时分配，因此总是使用默认的 resource，它必须是线程安全的
+        static JObject fromStringParallel(string_view content, size_t threads = 0, size_t min_chunk = 1 << 20);
+
+        // 序列化基本类型、JObject、枚举、optional、容器以及用 JSON_FIELDS 声明了字段的结构体，追加到 out 末尾
+        template <class T>
+        static void toJson(T const &src, string &out)
+        {
+            write_value(out, src);
+        }
+
+        template <class T>
+        static string toJson(T const &src)
+        {
+            string out;
+            write_value(out, src);
+            return out;
+        }
+
+        // 把 content 直接解析到 dst 中，类型不符时抛出异常
+        template <class T>
+        static void fromJson(string_view content, T &dst)
+        {
+            Parser parser;
+            parser.m_str = content;
+            parser.m_idx = 0;
 
-        template<class T>
-        static string toJson(T const& src){
-            // 基本类型
-            if constexpr(IS_TYPE(T,int_t)){
-                JObject object(src);
-                return object.to_string();
+            parser.read_value(dst);
+            if (parser.get_next_token() != 0)
+            {
+                parser.error("unexpected content after value");
             }
         }
+
+        template <class T>
+        static T fromJson(string_view content)
+        {
+            T dst{};
+            fromJson(content, dst);
+            return dst;
+        }
     };
 }
 
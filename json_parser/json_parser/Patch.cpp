@@ -0,0 +1,406 @@
+#include "Patch.h"
+
+namespace json
+{
+    // 取出操作中的成员，缺少时抛出异常
+    static const JObject &member(const JObject &operation, const char *name)
+    {
+        const JObject *value = operation.find(name);
+        if (value == nullptr)
+        {
+            throw std::logic_error(string("json patch: missing \"") + name + "\" in operation");
+        }
+        return *value;
+    }
+
+    vector<string> Patch::split_pointer(string_view pointer)
+    {
+        vector<string> tokens;
+        if (pointer.empty())
+        {
+            // 整个文档
+            return tokens;
+        }
+        if (pointer[0] != '/')
+        {
+            throw std::logic_error("json patch: pointer must start with '/': " + string(pointer));
+        }
+        for (size_t i = 0; i < pointer.size(); i++)
+        {
+            if (pointer[i] == '/')
+            {
+                tokens.emplace_back();
+            }
+            else if (pointer[i] == '~')
+            {
+                char next = i + 1 < pointer.size() ? pointer[i + 1] : 0;
+                if (next != '0' && next != '1')
+                {
+                    throw std::logic_error("json patch: bad escape in pointer: " + string(pointer));
+                }
+                tokens.back().push_back(next == '0' ? '~' : '/');
+                i++;
+            }
+            else
+            {
+                tokens.back().push_back(pointer[i]);
+            }
+        }
+        return tokens;
+    }
+
+    void Patch::append_token(string &pointer, string_view token)
+    {
+        pointer.push_back('/');
+        for (char c : token)
+        {
+            if (c == '~')
+            {
+                pointer += "~0";
+            }
+            else if (c == '/')
+            {
+                pointer += "~1";
+            }
+            else
+            {
+                pointer.push_back(c);
+            }
+        }
+    }
+
+    bool Patch::parse_index(const string &token, size_t &index)
+    {
+        if (token.empty() || token.size() > 18 || (token[0] == '0' && token.size() > 1))
+        {
+            return false;
+        }
+        index = 0;
+        for (char c : token)
+        {
+            if (c < '0' || c > '9')
+            {
+                return false;
+            }
+            index = index * 10 + size_t(c - '0');
+        }
+        return true;
+    }
+
+    const JObject *Patch::find(const JObject &root, const vector<string> &tokens, size_t count)
+    {
+        const JObject *current = &root;
+        for (size_t i = 0; i < count && current != nullptr; i++)
+        {
+            if (current->Type() == T_DICT)
+            {
+                current = current->find(tokens[i]);
+            }
+            else if (current->Type() == T_LIST)
+            {
+                auto &list = current->Value<list_t>();
+                size_t index;
+                current = parse_index(tokens[i], index) && index < list.size() ? &list[index] : nullptr;
+            }
+            else
+            {
+                current = nullptr;
+            }
+        }
+        return current;
+    }
+
+    JObject &Patch::locate(JObject &root, const vector<string> &tokens, size_t count)
+    {
+        JObject *current = &root;
+        for (size_t i = 0; i < count; i++)
+        {
+            JObject *next = nullptr;
+            // 只读地确认存在之后再取可写的引用，避免不必要的拷贝；
+            // 引用只在 Patch 内部使用，不标记 leaked，结果被拷贝时仍然共享
+            if (current->Type() == T_DICT && static_cast<const JObject *>(current)->find(tokens[i]) != nullptr)
+            {
+                next = current->member(tokens[i]);
+            }
+            else if (current->Type() == T_LIST)
+            {
+                size_t index;
+                if (parse_index(tokens[i], index) && index < static_cast<const JObject *>(current)->Value<list_t>().size())
+                {
+                    next = &current->unshared<list_t>()[index];
+                }
+            }
+            if (next == nullptr)
+            {
+                string path;
+                for (size_t j = 0; j <= i; j++)
+                {
+                    append_token(path, tokens[j]);
+                }
+                throw std::logic_error("json patch: path not found: " + path);
+            }
+            current = next;
+        }
+        return *current;
+    }
+
+    void Patch::add(JObject &root, const vector<string> &tokens, JObject value)
+    {
+        if (tokens.empty())
+        {
+            root = std::move(value);
+            return;
+        }
+        JObject &parent = locate(root, tokens, tokens.size() - 1);
+        const string &last = tokens.back();
+        if (parent.Type() == T_DICT)
+        {
+            parent.unshared<dict_t>().insert_or_assign(str_t(last), std::move(value));
+            return;
+        }
+        if (parent.Type() == T_LIST)
+        {
+            auto &list = parent.unshared<list_t>();
+            size_t index = list.size();
+            if (last != "-" && (!parse_index(last, index) || index > list.size()))
+            {
+                throw std::logic_error("json patch: bad list index: " + last);
+            }
+            list.insert(list.begin() + index, std::move(value));
+            return;
+        }
+        throw std::logic_error("json patch: parent is not a container: " + last);
+    }
+
+    JObject Patch::remove(JObject &root, const vector<string> &tokens)
+    {
+        if (tokens.empty())
+        {
+            throw std::logic_error("json patch: can't remove the whole document");
+        }
+        // 先确认存在，不存在时不拷贝任何容器
+        if (find(root, tokens, tokens.size()) == nullptr)
+        {
+            locate(root, tokens, tokens.size());
+        }
+        JObject &parent = locate(root, tokens, tokens.size() - 1);
+        const string &last = tokens.back();
+        if (parent.Type() == T_DICT)
+        {
+            JObject value = std::move(*parent.member(last));
+            parent.unshared<dict_t>().erase(string_view(last));
+            return value;
+        }
+        auto &list = parent.unshared<list_t>();
+        size_t index;
+        parse_index(last, index);
+        JObject value = std::move(list[index]);
+        list.erase(list.begin() + index);
+        return value;
+    }
+
+    JObject Patch::merge(const JObject &target, const JObject &patch)
+    {
+        if (patch.Type() != T_DICT)
+        {
+            return patch;
+        }
+        // 与 target 共享，修改时才拷贝
+        JObject result = target.Type() == T_DICT ? target : JObject(dict_t());
+        const JObject &current = result;
+        for (auto &[key, value] : patch.Value<dict_t>())
+        {
+            if (value.Type() == T_NULL)
+            {
+                if (current.contains(key))
+                {
+                    result.unshared<dict_t>().erase(string_view(key));
+                }
+                continue;
+            }
+            const JObject *old = current.find(key);
+            JObject merged = merge(old != nullptr ? *old : JObject(), value);
+            result.unshared<dict_t>().insert_or_assign(str_t(key), std::move(merged));
+        }
+        return result;
+    }
+
+    JObject Patch::mergeDiff(const JObject &source, const JObject &target)
+    {
+        if (source.Type() != T_DICT || target.Type() != T_DICT)
+        {
+            return target;
+        }
+        dict_t patch;
+        for (auto &[key, value] : source.Value<dict_t>())
+        {
+            if (!target.contains(key))
+            {
+                patch.emplace(key, JObject());
+            }
+        }
+        for (auto &[key, value] : target.Value<dict_t>())
+        {
+            const JObject *old = source.find(key);
+            if (old == nullptr)
+            {
+                patch.emplace(key, value);
+            }
+            else if (*old != value)
+            {
+                patch.emplace(key, mergeDiff(*old, value));
+            }
+        }
+        return JObject(std::move(patch));
+    }
+
+    JObject Patch::apply(const JObject &document, const JObject &patch)
+    {
+        if (patch.Type() != T_LIST)
+        {
+            throw std::logic_error("json patch: patch must be a list");
+        }
+        JObject result = document;
+        for (auto &operation : patch.Value<list_t>())
+        {
+            if (operation.Type() != T_DICT)
+            {
+                throw std::logic_error("json patch: operation must be a dict");
+            }
+            const str_t &op = member(operation, "op").Value<str_t>();
+            vector<string> path = split_pointer(member(operation, "path").Value<str_t>());
+            if (op == "add")
+            {
+                add(result, path, member(operation, "value"));
+            }
+            else if (op == "remove")
+            {
+                remove(result, path);
+            }
+            else if (op == "replace")
+            {
+                locate(result, path, path.size()) = member(operation, "value");
+            }
+            else if (op == "move")
+            {
+                vector<string> from = split_pointer(member(operation, "from").Value<str_t>());
+                if (from.size() < path.size() && std::equal(from.begin(), from.end(), path.begin()))
+                {
+                    throw std::logic_error("json patch: can't move a value into itself");
+                }
+                add(result, path, remove(result, from));
+            }
+            else if (op == "copy")
+            {
+                vector<string> from = split_pointer(member(operation, "from").Value<str_t>());
+                // 拷贝只增加引用计数
+                JObject value = locate(result, from, from.size());
+                add(result, path, std::move(value));
+            }
+            else if (op == "test")
+            {
+                const JObject *value = find(result, path, path.size());
+                if (value == nullptr || *value != member(operation, "value"))
+                {
+                    throw std::logic_error("json patch: test failed: " + string(member(operation, "path").Value<str_t>()));
+                }
+            }
+            else
+            {
+                throw std::logic_error("json patch: unknown op: " + string(op));
+            }
+        }
+        return result;
+    }
+
+    JObject Patch::operation(const char *op, const string &path, const JObject *value)
+    {
+        dict_t operation;
+        operation.emplace("op", JObject(op));
+        operation.emplace("path", JObject(path));
+        if (value != nullptr)
+        {
+            operation.emplace("value", *value);
+        }
+        return JObject(std::move(operation));
+    }
+
+    void Patch::diff(const JObject &source, const JObject &target, string &path, list_t &operations)
+    {
+        size_t length = path.size();
+        if (source.Type() == T_DICT && target.Type() == T_DICT)
+        {
+            auto &source_dict = source.Value<dict_t>();
+            auto &target_dict = target.Value<dict_t>();
+            // 共享同一个容器，没有修改过
+            if (&source_dict == &target_dict)
+            {
+                return;
+            }
+            for (auto &[key, value] : source_dict)
+            {
+                if (target_dict.find(key) == target_dict.end())
+                {
+                    append_token(path, key);
+                    operations.push_back(operation("remove", path, nullptr));
+                    path.resize(length);
+                }
+            }
+            for (auto &[key, value] : target_dict)
+            {
+                append_token(path, key);
+                auto it = source_dict.find(key);
+                if (it == source_dict.end())
+                {
+                    operations.push_back(operation("add", path, &value));
+                }
+                else
+                {
+                    diff(it->second, value, path, operations);
+                }
+                path.resize(length);
+            }
+        }
+        else if (source.Type() == T_LIST && target.Type() == T_LIST)
+        {
+            auto &source_list = source.Value<list_t>();
+            auto &target_list = target.Value<list_t>();
+            if (&source_list == &target_list)
+            {
+                return;
+            }
+            size_t common = std::min(source_list.size(), target_list.size());
+            for (size_t i = 0; i < common; i++)
+            {
+                append_token(path, std::to_string(i));
+                diff(source_list[i], target_list[i], path, operations);
+                path.resize(length);
+            }
+            // 从后往前删除，前面的下标不变
+            for (size_t i = source_list.size(); i-- > common;)
+            {
+                append_token(path, std::to_string(i));
+                operations.push_back(operation("remove", path, nullptr));
+                path.resize(length);
+            }
+            for (size_t i = common; i < target_list.size(); i++)
+            {
+                append_token(path, std::to_string(i));
+                operations.push_back(operation("add", path, &target_list[i]));
+                path.resize(length);
+            }
+        }
+        else if (source != target)
+        {
+            operations.push_back(operation("replace", path, &target));
+        }
+    }
+
+    JObject Patch::diff(const JObject &source, const JObject &target)
+    {
+        list_t operations;
+        string path;
+        diff(source, target, path, operations);
+        return JObject(std::move(operations));
+    }
+}
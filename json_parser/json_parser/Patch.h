@@ -0,0 +1,60 @@
+#ifndef MYUTIL_PATCH_H
+#define MYUTIL_PATCH_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "JObject.h"
+
+namespace json
+{
+    // 增量更新 json 文档：RFC 7386 merge patch 与 RFC 6902 JSON Patch
+    // 结果与输入共享没有修改的子树（JObject 的 copy-on-write），被修改的路径上每一层拷贝一次：
+    // dict 只拷贝段的指针与被修改的成员所在的一段（见 ChunkedDict），list 整层拷贝，代价与 dict 的宽度无关
+    class Patch
+    {
+    private:
+        // 按 RFC 6901 把 JSON Pointer 拆成各级 token，处理 ~0 与 ~1
+        static vector<string> split_pointer(string_view pointer);
+
+        // 把 token 转义后作为一级追加到 pointer 末尾
+        static void append_token(string &pointer, string_view token);
+
+        // 解析 list 的下标，不允许前导 0，不是下标时返回 false
+        static bool parse_index(const string &token, size_t &index);
+
+        // 只读地查找 tokens 的前 count 级，不存在时返回 nullptr
+        static const JObject *find(const JObject &root, const vector<string> &tokens, size_t count);
+
+        // 可写地查找 tokens 的前 count 级，沿途拷贝共享的容器，不存在时抛出异常
+        static JObject &locate(JObject &root, const vector<string> &tokens, size_t count);
+
+        // 在 tokens 处插入或覆盖 value，list 的最后一级可以是 "-" 或长度，表示追加
+        static void add(JObject &root, const vector<string> &tokens, JObject value);
+
+        // 删除 tokens 处的值并返回
+        static JObject remove(JObject &root, const vector<string> &tokens);
+
+        // 把 source 变为 target 的操作追加到 operations，path 为当前位置
+        static void diff(const JObject &source, const JObject &target, string &path, list_t &operations);
+
+        // 构造一个操作 {"op": op, "path": path, "value": *value}
+        static JObject operation(const char *op, const string &path, const JObject *value);
+
+    public:
+        // 把 merge patch 应用到 target 上，返回新的文档
+        static JObject merge(const JObject &target, const JObject &patch);
+
+        // 生成把 source 变为 target 的 merge patch
+        // merge patch 中 null 表示删除，因此 target 中值为 null 的成员无法表示
+        static JObject mergeDiff(const JObject &source, const JObject &target);
+
+        // 把 JSON Patch 应用到 document 上，返回新的文档；任一操作失败时抛出异常，document 不受影响
+        static JObject apply(const JObject &document, const JObject &patch);
+
+        // 生成把 source 变为 target 的 JSON Patch，list 按下标逐个比较，不计算最长公共子序列
+        static JObject diff(const JObject &source, const JObject &target);
+    };
+}
+
+#endif // MYUTIL_PATCH_H
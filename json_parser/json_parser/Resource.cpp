@@ -0,0 +1,39 @@
+#include "Resource.h"
+
+namespace json
+{
+    void *CountingResource::do_allocate(size_t bytes, size_t alignment)
+    {
+        void *p = this->m_upstream->allocate(bytes, alignment);
+        this->m_allocations++;
+        this->m_allocated_bytes += bytes;
+        size_t in_use = this->m_bytes_in_use += bytes;
+        // 多个线程同时分配时只保留最大的值
+        size_t peak = this->m_peak_bytes;
+        while (in_use > peak && !this->m_peak_bytes.compare_exchange_weak(peak, in_use))
+        {
+        }
+        return p;
+    }
+
+    void CountingResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+    {
+        this->m_upstream->deallocate(p, bytes, alignment);
+        this->m_deallocations++;
+        this->m_bytes_in_use -= bytes;
+    }
+
+    bool CountingResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+    {
+        return this == &other;
+    }
+
+    void CountingResource::reset()
+    {
+        this->m_allocations = 0;
+        this->m_deallocations = 0;
+        this->m_allocated_bytes = 0;
+        // 还有未释放的内存，bytes_in_use 保留，否则之后的释放会让它回绕；峰值从当前占用重新开始
+        this->m_peak_bytes = this->m_bytes_in_use.load();
+    }
+}
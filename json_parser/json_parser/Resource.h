@@ -0,0 +1,67 @@
+#ifndef MYUTIL_RESOURCE_H
+#define MYUTIL_RESOURCE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+namespace json
+{
+    // 统计分配次数与字节数，再转发给 upstream，计数是原子的，可以在 fromStringParallel 中使用
+    // 传给 std::pmr::set_default_resource() 后，JObject 树的所有分配都经过它
+    class CountingResource : public std::pmr::memory_resource
+    {
+    private:
+        std::pmr::memory_resource *m_upstream;
+        std::atomic<size_t> m_allocations{0};
+        std::atomic<size_t> m_deallocations{0};
+        std::atomic<size_t> m_allocated_bytes{0};
+        std::atomic<size_t> m_bytes_in_use{0};
+        std::atomic<size_t> m_peak_bytes{0};
+
+    protected:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    public:
+        explicit CountingResource(std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+            : m_upstream(upstream)
+        {
+        }
+
+        size_t allocations() const
+        {
+            return this->m_allocations;
+        }
+
+        size_t deallocations() const
+        {
+            return this->m_deallocations;
+        }
+
+        // 累计分配的字节数
+        size_t allocated_bytes() const
+        {
+            return this->m_allocated_bytes;
+        }
+
+        // 当前尚未释放的字节数
+        size_t bytes_in_use() const
+        {
+            return this->m_bytes_in_use;
+        }
+
+        size_t peak_bytes() const
+        {
+            return this->m_peak_bytes;
+        }
+
+        // 清零累计的分配、释放次数与字节数，bytes_in_use 不变，peak_bytes 从当前占用重新开始
+        void reset();
+    };
+}
+
+#endif // MYUTIL_RESOURCE_H
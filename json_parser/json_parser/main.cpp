@@ -1,9 +1,17 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <vector>
 #include "JObject.h"
 #include "Parser.h"
-#include "../benchmark/timer.hpp"
-#include "../magic_template/scienum.h"
+#include "Patch.h"
+#include "Resource.h"
+#include "../../benchmark/timer.hpp"
+#include "../../magic_template/scienum.h"
 
 using namespace std;
 
@@ -18,31 +26,262 @@ struct Base
     int pp;
     string qq;
 
-    // START_FROM JSON
+    JSON_FIELDS(pp, qq)
 };
 
 struct Mytest
 {
+    T kind = MYSD;
+    Base base;
+    vector<Base> list;
+    map<string, double> scores;
+    optional<string> comment;
+
+    JSON_FIELDS(kind, base, list, scores, comment)
 };
 
+string read_file(const string &path);
 void test_class_serialization();
 void test_string_parser();
+void test_parallel_parser();
+void test_memory_usage();
+void test_patch();
+void test_copy_on_write();
 
 int main()
 {
-    // g++ -o main main.cpp JObject.cpp Parser.cpp -I ..\benchmark -I ..\magic_template && ./main
+    // g++ -O2 -pthread -o main main.cpp JObject.cpp Parser.cpp Patch.cpp Resource.cpp -std=c++17 && ./main
     test_string_parser();
+    test_parallel_parser();
+    test_memory_usage();
+    test_patch();
+    test_copy_on_write();
+    test_class_serialization();
 
     return 0;
 }
 
+// 读取整个文件
+string read_file(const string &path)
+{
+    std::ifstream fin(path, std::ios::binary);
+    if (!fin)
+    {
+        throw std::logic_error("can't open file: " + path);
+    }
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    return ss.str();
+}
+
 void test_class_serialization()
 {
-    cout << "test" << endl;
+    cout << "test class serialization" << endl;
+    Mytest test;
+    test.kind = sf;
+    test.base = {1, "base"};
+    test.list = {{2, "a"}, {3, "b\"quoted\""}};
+    test.scores = {{"x", 0.5}, {"y", 2}};
+
+    string content = json::Parser::toJson(test);
+    cout << content << endl;
+
+    Mytest copy = json::Parser::fromJson<Mytest>(content);
+    cout << (json::Parser::toJson(copy) == content ? "round trip ok" : "round trip mismatch") << endl;
 }
 
 void test_string_parser()
 {
-    cout<<"test string to parser"<<endl;
-    std::ifstream fin(R"(../test_resources/test.json)");
+    cout << "test string to parser" << endl;
+    string content = read_file("../../test_resources/test.json");
+
+    json::JObject object = json::Parser::fromString(content);
+    cout << "dict size: " << object.Value<json::dict_t>().size() << ", to_string size: " << object.to_string().size() << endl;
+    cout << "sizeof(JObject): " << sizeof(json::JObject) << endl;
+
+    // 吞吐
+    const int iterations = 200;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        json::Parser::fromString(content);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("fromString: %.2f us/doc, %.2f MB/s\n", seconds * 1e6 / iterations,
+           content.size() * double(iterations) / seconds / (1024 * 1024));
+}
+
+void test_parallel_parser()
+{
+    cout << "test parallel parser" << endl;
+    string element = read_file("../../test_resources/test.json");
+
+    // 顶层为数组的大文档
+    string content = "[";
+    for (int i = 0; i < 400; i++)
+    {
+        content += i == 0 ? "" : ",";
+        content += element;
+    }
+    content += "]";
+
+    auto start = chrono::steady_clock::now();
+    json::JObject serial = json::Parser::fromString(content);
+    double serial_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    json::JObject parallel = json::Parser::fromStringParallel(content);
+    double parallel_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%.1f MB, fromString: %.1f ms, fromStringParallel: %.1f ms, %s\n", content.size() / (1024.0 * 1024),
+           serial_seconds * 1e3, parallel_seconds * 1e3, serial.to_string() == parallel.to_string() ? "identical" : "mismatch");
+}
+
+void test_memory_usage()
+{
+    cout << "test memory usage" << endl;
+    string content = read_file("../../test_resources/test.json");
+
+    // 解析期间的分配都经过 counter
+    json::CountingResource counter;
+    std::pmr::memory_resource *previous = std::pmr::set_default_resource(&counter);
+    {
+        json::JObject object = json::Parser::fromString(content);
+        printf("parse: %zu allocations, %zu bytes allocated, %zu bytes in use\n", counter.allocations(),
+               counter.allocated_bytes(), counter.bytes_in_use());
+
+        json::MemoryUsage usage = object.memory_usage();
+        printf("nodes: null %zu, bool %zu, int %zu, double %zu, str %zu, list %zu, dict %zu\n", usage.nodes[json::T_NULL],
+               usage.nodes[json::T_BOOL], usage.nodes[json::T_INT], usage.nodes[json::T_DOUBLE], usage.nodes[json::T_STR],
+               usage.nodes[json::T_LIST], usage.nodes[json::T_DICT]);
+        printf("bytes: string %zu, list %zu, dict %zu, total %zu (%.1f per node)\n", usage.string_bytes, usage.list_bytes,
+               usage.dict_bytes, usage.total_bytes(), double(usage.total_bytes()) / usage.node_count());
+    }
+
+    // 整棵树分配在一次请求的 arena 上，arena 析构时整体释放
+    counter.reset();
+    {
+        std::pmr::monotonic_buffer_resource arena(&counter);
+        json::JObject object = json::Parser::fromString(content, &arena);
+        printf("arena parse: %zu allocations, %zu bytes allocated\n", counter.allocations(), counter.allocated_bytes());
+    }
+    std::pmr::set_default_resource(previous);
+}
+
+void test_patch()
+{
+    cout << "test patch" << endl;
+    string content = read_file("../../test_resources/test.json");
+
+    // doc 也分配在 counter 上：detach() 在被拷贝的容器自己的分配器上拷贝这一层，这些分配同样计入
+    json::CountingResource counter;
+    std::pmr::memory_resource *previous = std::pmr::set_default_resource(&counter);
+    {
+        json::JObject doc = json::Parser::fromString(content);
+        const json::JObject &cdoc = doc;
+
+        // 修改一处：路径上的每一层（根与 "[json]"）只拷贝被修改的成员所在的那一段，其余的段与子树与 doc 共享
+        json::JObject patch = json::Parser::fromString(R"([{"op":"add","path":"/[json]/editor.tabSize","value":4}])");
+        counter.reset();
+        json::JObject patched = json::Patch::apply(doc, patch);
+        size_t apply_allocations = counter.allocations();
+        printf("apply: %zu allocations, %zu bytes (path: %zu + %zu members)\n", apply_allocations, counter.allocated_bytes(),
+               cdoc.Value<json::dict_t>().size(), cdoc.at("[json]").Value<json::dict_t>().size());
+
+        counter.reset();
+        json::JObject copy = doc.clone();
+        printf("clone: %zu allocations, %zu bytes\n", counter.allocations(), counter.allocated_bytes());
+
+        // 根有 1590 个成员，改动一处的代价不应随根的宽度增长
+        if (apply_allocations * 10 > counter.allocations())
+        {
+            throw std::logic_error("test patch: apply copies whole levels");
+        }
+
+        // Patch 内部的引用不算交出，结果仍然可以共享
+        counter.reset();
+        json::JObject shared = patched;
+        if (counter.allocations() != 0)
+        {
+            throw std::logic_error("test patch: result is not shareable");
+        }
+
+        cout << json::Patch::diff(doc, patched).to_string() << endl;
+        cout << json::Patch::mergeDiff(doc, patched).to_string() << endl;
+    }
+    std::pmr::set_default_resource(previous);
+}
+
+void test_copy_on_write()
+{
+    cout << "test copy on write" << endl;
+    auto check = [](const json::JObject &object, const char *expected, const char *name)
+    {
+        if (object.to_string() != expected)
+        {
+            throw std::logic_error(string("test copy on write: ") + name + ": " + object.to_string());
+        }
+    };
+
+    // 先取可写的引用再拷贝：之后通过引用的修改只影响原来的 JObject，不影响拷贝
+    string wide = "{\"k\":0";
+    for (int i = 0; i < 100; i++)
+    {
+        wide += ",\"x" + std::to_string(i) + "\":0";
+    }
+    wide += "}";
+    // 未切分的 dict 与切分之后的 dict
+    for (const string &content : {string(R"({"k":0})"), wide})
+    {
+        json::JObject c = json::Parser::fromString(content);
+        auto &k = c["k"];
+        json::JObject d = c;
+        k = json::int_t(1);
+        check(c.at("k"), "1", "dict");
+        check(static_cast<const json::JObject &>(d).at("k"), "0", "dict copy");
+    }
+
+    // 引用在 dict 切分之前取得，"z" 随着段的拆开移到新的段中
+    json::JObject c = json::Parser::fromString(R"({"z":0})");
+    auto &z = c["z"];
+    // insert_or_assign 不交出引用，不会因此标记 "z" 所在的段
+    auto &members = c.Value<json::dict_t>();
+    for (int i = 0; i < 100; i++)
+    {
+        members.insert_or_assign(json::str_t("x" + std::to_string(i)), json::int_t(i));
+    }
+    json::JObject d = c;
+    z = json::int_t(1);
+    check(static_cast<const json::JObject &>(d).at("z"), "0", "split dict copy");
+
+    // 嵌套的 dict 与 list
+    json::JObject nested = json::Parser::fromString(R"({"a":{"b":[0]}})");
+    auto &item = nested["a"]["b"].Value<json::list_t>()[0];
+    json::JObject nested_copy = nested;
+    item = json::int_t(1);
+    check(nested, R"({"a":{"b":[1]}})", "nested");
+    check(nested_copy, R"({"a":{"b":[0]}})", "nested copy");
+
+    // 整个 dict_t 的引用
+    json::JObject whole = json::Parser::fromString(R"({"k":0})");
+    auto &dict = whole.Value<json::dict_t>();
+    json::JObject whole_copy = whole;
+    dict["n"] = json::int_t(1);
+    check(whole_copy, R"({"k":0})", "dict_t copy");
+
+    // arena 上的树的拷贝在默认的 memory_resource 上，arena 释放后仍可使用
+    char buffer[4096];
+    json::JObject kept;
+    json::JObject kept_member;
+    {
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+        json::JObject parsed = json::Parser::fromString(R"({"a":{"b":["c"]},"d":[1]})", &arena);
+        kept = parsed;
+        kept_member = json::JObject(static_cast<const json::JObject &>(parsed).at("a"));
+    }
+    std::fill(buffer, buffer + sizeof(buffer), 0);
+    check(kept, R"({"a":{"b":["c"]},"d":[1]})", "arena copy");
+    check(kept_member, R"({"b":["c"]})", "arena member copy");
+
+    cout << "copy on write ok" << endl;
 }
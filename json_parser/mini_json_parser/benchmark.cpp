@@ -0,0 +1,365 @@
+#include <chrono>
+#include <filesystem>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include "parser.h"
+#include "document.h"
+#include "structuralIndex.h"
+#include "writer.h"
+#include "query.h"
+#include "lazyDocument.h"
+#include "msgpack.h"
+#include "mappedFile.h"
+
+using namespace civitasv::json;
+
+std::string readFile(const std::string &path)
+{
+    std::ifstream fin(path, std::ios::binary);
+    if (!fin)
+    {
+        error("can't open file: " + path);
+    }
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    return ss.str();
+}
+
+// 运行 iterations 次 func，输出平均耗时与吞吐
+void bench(const char *name, size_t bytes, int iterations, const std::function<void()> &func)
+{
+    // 预热
+    func();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        func();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double us = seconds * 1e6 / iterations;
+    double mbps = bytes * (double)iterations / seconds / (1024 * 1024);
+    printf("%-24s %10.2f us/doc %10.2f MB/s\n", name, us, mbps);
+    fflush(stdout);
+}
+
+// 堆分配：逐个 new，逐个 delete
+void benchHeap(const std::string &source, int iterations)
+{
+    bench("heap parse+free", source.size(), iterations, [&]()
+          {
+              Parser parser{Scanner(std::string_view(source))};
+              JsonElement *root = parser.parse();
+              delete root; });
+}
+
+// arena 分配：连续分配，整体释放
+void benchArena(const std::string &source, int iterations)
+{
+    bench("arena parse+free", source.size(), iterations, [&]()
+          {
+              Document document;
+              Parser parser{Scanner(std::string_view(source))};
+              parser.parse(document); });
+}
+
+// 逐字符扫描与索引扫描的对比，以及第一阶段单独的吞吐
+void benchIndex(const std::string &source, int iterations)
+{
+    bench("plain parse+free", source.size(), iterations, [&]()
+          {
+              Document document;
+              Parser parser{Scanner(std::string_view(source))};
+              parser.parse(document); });
+
+    bench("indexed parse+free", source.size(), iterations, [&]()
+          {
+              Document document;
+              Scanner scanner{std::string_view(source)};
+              scanner.buildIndex();
+              Parser parser(std::move(scanner));
+              parser.parse(document); });
+
+    const std::pair<const char *, StructuralIndexer::Implementation> implementations[] = {
+        {"stage1 scalar", StructuralIndexer::Implementation::SCALAR},
+        {"stage1 sse2", StructuralIndexer::Implementation::SSE2},
+        {"stage1 avx2", StructuralIndexer::Implementation::AVX2},
+    };
+    std::vector<uint32_t> index;
+    for (auto &[name, implementation] : implementations)
+    {
+        if (implementation > StructuralIndexer::best())
+        {
+            continue;
+        }
+        StructuralIndexer indexer(implementation);
+        bench(name, source.size(), iterations, [&]()
+              { indexer.index(source, index); });
+    }
+}
+
+// 旧版 dumps() 的实现：每个节点一个 stringstream，递归拼接子节点的结果，用于对比
+std::string legacyDumps(JsonElement *element)
+{
+    std::stringstream ss;
+    switch (element->type())
+    {
+    case JsonElement::Type::JSON_OBJECT:
+    {
+        JsonObject *object = element->asObject();
+        ss << "{";
+        for (auto iter = object->begin(); iter != object->end(); iter++)
+        {
+            ss << "\"" << iter->first << "\""
+               << ": " << legacyDumps(iter->second);
+            if (iter != --object->end())
+            {
+                ss << ",";
+            }
+        }
+        ss << "}";
+        break;
+    }
+    case JsonElement::Type::JSON_ARRAY:
+    {
+        JsonArray *array = element->asArray();
+        ss << "[";
+        for (size_t i = 0; i < array->size(); i++)
+        {
+            ss << legacyDumps((*array)[i]);
+            if (i != array->size() - 1)
+            {
+                ss << ",";
+            }
+        }
+        ss << "]";
+        break;
+    }
+    case JsonElement::Type::JSON_STRING:
+    {
+        ss << '\"' << *element->asString() << '\"';
+        break;
+    }
+    case JsonElement::Type::JSON_NUMBER:
+    {
+        ss << element->asNumber();
+        break;
+    }
+    case JsonElement::Type::JSON_BOOL:
+    {
+        ss << (element->asBool() ? "true" : "false");
+        break;
+    }
+    default:
+    {
+        ss << "null";
+        break;
+    }
+    }
+    return ss.str();
+}
+
+// 序列化：旧版 stringstream 实现与 Writer 的对比，吞吐按输出字节计算
+void benchWrite(const std::string &source, int iterations)
+{
+    Document document;
+    Parser parser{Scanner(std::string_view(source))};
+    parser.parse(document);
+    JsonElement *root = document.root();
+
+    size_t bytes = root->dumps().size();
+    bench("legacy dumps", bytes, iterations, [&]()
+          { legacyDumps(root); });
+
+    bench("dumps", bytes, iterations, [&]()
+          { root->dumps(); });
+
+    // 复用同一块缓冲，不再分配
+    std::string buffer;
+    bench("writer reuse buffer", bytes, iterations, [&]()
+          {
+              buffer.clear();
+              Writer writer(buffer);
+              writer.write(root); });
+
+    bench("writer pretty", root->dumps(4).size(), iterations, [&]()
+          {
+              buffer.clear();
+              Writer writer(buffer, 4);
+              writer.write(root); });
+}
+
+// 宽对象：解析一个有 count 个成员的对象，并逐个按 key 查找
+void benchWideObject(size_t count, int iterations)
+{
+    std::string source = "{";
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < count; i++)
+    {
+        keys.push_back("key_" + std::to_string(i * 7919 % count));
+        source += (i == 0 ? "\"" : ",\"") + keys.back() + "\":" + std::to_string(i);
+    }
+    source += "}";
+
+    bench("wide object parse", source.size(), iterations, [&]()
+          {
+              Document document;
+              Parser parser{Scanner(std::string_view(source))};
+              parser.parse(document); });
+
+    Document document;
+    Parser parser{Scanner(std::string_view(source))};
+    parser.parse(document);
+    JsonObject *object = document.root()->asObject();
+    size_t found = 0;
+    bench("wide object lookup", source.size(), iterations, [&]()
+          {
+              for (auto &key : keys)
+              {
+                  found += object->count(std::string_view(key));
+              } });
+}
+
+// 取出一个字段：完整解析后在树上查找，与直接在 Scanner 上查询的对比
+void benchQuery(const std::string &source, const std::string &pointer, int iterations)
+{
+    bench("parse+find", source.size(), iterations, [&]()
+          {
+              Document document;
+              Parser parser{Scanner(std::string_view(source))};
+              parser.parse(document);
+              find(document.root(), pointer); });
+
+    JsonPath path = JsonPath::fromPointer(pointer);
+    bench("query", source.size(), iterations, [&]()
+          {
+              Document document;
+              Scanner scanner{std::string_view(source)};
+              Query query(path);
+              query.first(scanner, document.resource()); });
+}
+
+// 读取少数几个字段：完整解析与按需展开的对比
+void benchLazy(const std::string &source, const std::vector<std::string> &keys, int iterations)
+{
+    bench("parse+read fields", source.size(), iterations, [&]()
+          {
+              Document document;
+              Parser parser{Scanner(std::string_view(source))};
+              parser.parse(document);
+              JsonObject *object = document.root()->asObject();
+              for (auto &key : keys)
+              {
+                  object->find(key);
+              } });
+
+    bench("lazy+read fields", source.size(), iterations, [&]()
+          {
+              LazyDocument document(source);
+              for (auto &key : keys)
+              {
+                  document.root()->find(key);
+              } });
+}
+
+// 字符串为主的文档：长 ASCII 文本、中文与转义字符
+void benchStrings(int iterations)
+{
+    std::string source = "[";
+    for (int i = 0; i < 2000; i++)
+    {
+        source += i == 0 ? "" : ",";
+        source += "\"The quick brown fox jumps over the lazy dog, 敏捷的棕色狐狸跳过了懒狗\"";
+        source += i % 4 == 0 ? ",\"line\\nbreak \\u00e9\\ud83d\\ude00 \\\"quoted\\\"\"" : "";
+    }
+    source += "]";
+
+    bench("string-heavy parse", source.size(), iterations, [&]()
+          {
+              Document document;
+              Parser parser{Scanner(std::string_view(source))};
+              parser.parse(document); });
+}
+
+// 加载：文本解析与读取 MessagePack 的对比，后者也从 mmap 的文件中直接读取
+void benchMsgpack(const std::string &source, int iterations)
+{
+    Document text;
+    Parser{Scanner(std::string_view(source))}.parse(text);
+    std::string binary;
+    MsgpackWriter(binary).write(text.root());
+    printf("  msgpack: %zu bytes (%.1f%% of text)\n", binary.size(), 100.0 * binary.size() / source.size());
+
+    std::string path = (std::filesystem::temp_directory_path() / "mini_json_benchmark.msgpack").string();
+    std::ofstream(path, std::ios::binary) << binary;
+
+    bench("text load", source.size(), iterations, [&]()
+          {
+              Document document;
+              Parser parser{Scanner(std::string_view(source))};
+              parser.parse(document); });
+
+    bench("msgpack load", binary.size(), iterations, [&]()
+          {
+              Document document;
+              MsgpackReader(binary).parse(document); });
+
+    bench("msgpack mmap+load", binary.size(), iterations, [&]()
+          {
+              MappedFile file(path);
+              Document document;
+              MsgpackReader(file.view()).parse(document); });
+
+    bench("msgpack write", binary.size(), iterations, [&]()
+          {
+              binary.clear();
+              MsgpackWriter(binary).write(text.root()); });
+
+    std::filesystem::remove(path);
+}
+
+// 将 source 复制 times 份，拼成一个大数组
+std::string scaleUp(const std::string &source, int times)
+{
+    std::string result = "[";
+    for (int i = 0; i < times; i++)
+    {
+        if (i != 0)
+        {
+            result += ",\n";
+        }
+        result += source;
+    }
+    result += "]";
+    return result;
+}
+
+int main(int argc, const char **argv)
+{
+    // g++ -O2 -o benchmark benchmark.cpp scanner.cpp parser.cpp structuralIndex.cpp number.cpp reader.cpp treeBuilder.cpp writer.cpp query.cpp lazyDocument.cpp utf8.cpp msgpack.cpp mappedFile.cpp -std=c++17 && ./benchmark ../../test_resources/test.json
+    std::string path = argc > 1 ? argv[1] : "../../test_resources/test.json";
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 200;
+
+    std::string source = readFile(path);
+    printf("%s: %zu bytes, %d iterations\n", path.c_str(), source.size(), iterations);
+
+    benchHeap(source, iterations);
+    benchArena(source, iterations);
+    benchWrite(source, iterations);
+    benchWideObject(10000, iterations);
+    benchQuery(source, "/zenMode.restore", iterations);
+    benchStrings(iterations);
+    benchLazy(source, {"[go]", "editor.fontSize", "zenMode.restore"}, iterations);
+    benchMsgpack(source, iterations);
+
+    std::string large = scaleUp(source, 256);
+    printf("scaled up: %zu bytes\n", large.size());
+    benchIndex(large, 5);
+
+    return 0;
+}
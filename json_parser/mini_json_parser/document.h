@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory_resource>
+#include "jsonElement.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 持有一块 arena，解析出的节点、容器和字符串都从 arena 上连续分配
+        // 节点不会单独析构，Document 销毁时整体释放，代价为 O(1)
+        class Document
+        {
+        public:
+            // initial_size 为第一块 chunk 的大小，后续 chunk 按几何级数增长
+            explicit Document(size_t initial_size = 64 * 1024) : arena_(initial_size) {}
+
+            Document(const Document &) = delete;
+            Document &operator=(const Document &) = delete;
+
+            // 根节点，未解析时为 nullptr
+            JsonElement *root() { return this->root_; }
+
+            void root(JsonElement *element) { this->root_ = element; }
+
+            std::pmr::memory_resource *resource() { return &this->arena_; }
+
+            // 丢弃整棵树，释放 arena 上的全部内存
+            void clear()
+            {
+                this->root_ = nullptr;
+                this->arena_.release();
+            }
+
+        private:
+            std::pmr::monotonic_buffer_resource arena_;
+            JsonElement *root_ = nullptr;
+        };
+    }
+}
@@ -11,5 +11,56 @@ namespace civitasv
         {
             throw std::logic_error(msg);
         }
+
+        // 解析错误的类别
+        enum class ErrorCode
+        {
+            NONE,
+            // 值还没结束输入就结束了
+            UNEXPECTED_END,
+            // 无法识别的字符或拼写错误的 true/false/null
+            INVALID_TOKEN,
+            // 数字格式错误
+            INVALID_NUMBER,
+            // 字符串中的控制字符、错误的转义、非法 UTF-8、缺少结束的引号等
+            INVALID_STRING,
+            // token 本身合法，但不该出现在这个位置
+            UNEXPECTED_TOKEN,
+            // 超过最大嵌套深度
+            DEPTH_EXCEEDED
+        };
+
+        // 解析错误及其位置：offset 为字节偏移，从 0 开始；line 与 column 从 1 开始，column 按字节计
+        struct ParseError
+        {
+            ErrorCode code = ErrorCode::NONE;
+            // 静态字符串，不需要释放
+            const char *message = "";
+            size_t offset = 0;
+            size_t line = 0;
+            size_t column = 0;
+
+            // 是否有错误
+            explicit operator bool() const { return this->code != ErrorCode::NONE; }
+
+            // 带位置的错误信息
+            std::string describe() const
+            {
+                return std::string(this->message) + " (line " + std::to_string(this->line) +
+                       ", column " + std::to_string(this->column) + ")";
+            }
+        };
+
+        // 抛出异常的接口报告的解析错误，仍然是 std::logic_error，额外带有错误的位置
+        class ParseException : public std::logic_error
+        {
+        public:
+            explicit ParseException(const ParseError &error) : std::logic_error(error.describe()), error_(error) {}
+
+            const ParseError &error() const { return this->error_; }
+
+        private:
+            ParseError error_;
+        };
     }
 }
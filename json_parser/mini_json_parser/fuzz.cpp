@@ -0,0 +1,430 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "parser.h"
+#include "reader.h"
+#include "document.h"
+#include "streamParser.h"
+#include "treeBuilder.h"
+#include "writer.h"
+#include "query.h"
+#include "lazyDocument.h"
+#include "msgpack.h"
+
+using namespace civitasv::json;
+
+// 差分测试：同一份输入交给不同的解析路径，结果必须一致，任何不一致都直接 abort
+// 以 Parser 解析后 dumps() 的结果为基准，与以下路径比较：
+// 索引扫描、SAX + Writer、分段喂入 StreamParser、在原始输入上 LazyDocument 完整展开、dumps() 之后再解析一次，
+// 以及在规范化的文本上 LazyDocument 完整展开、MessagePack 往返、Query 与树上查询
+
+// 报告不一致的输入并终止
+[[noreturn]] void fail(const char *what, std::string_view input, const std::string &expected, const std::string &actual)
+{
+    fprintf(stderr, "MISMATCH: %s\ninput (%zu bytes): ", what, input.size());
+    for (unsigned char c : input)
+    {
+        if (c >= 0x20 && c < 0x7f && c != '\\')
+        {
+            fputc(c, stderr);
+        }
+        else
+        {
+            fprintf(stderr, "\\x%02x", c);
+        }
+    }
+    fprintf(stderr, "\nexpected: %s\nactual:   %s\n", expected.c_str(), actual.c_str());
+    abort();
+}
+
+// 解析为紧凑的 JSON 文本，出错时返回 false
+bool parseText(std::string_view input, bool indexed, std::string &out)
+{
+    Scanner scanner(input);
+    if (indexed)
+    {
+        scanner.buildIndex();
+    }
+    Document document;
+    Parser parser(std::move(scanner));
+    if (parser.tryParse(document))
+    {
+        return false;
+    }
+    out = document.root()->dumps();
+    return true;
+}
+
+// 以 SAX 事件直接写出，重复的 key 会原样保留，因此再解析一次后比较
+bool parseSax(std::string_view input, std::string &out)
+{
+    std::string text;
+    Writer writer(text);
+    Parser parser{Scanner(input)};
+    if (parser.tryParse(writer))
+    {
+        return false;
+    }
+    if (text.empty())
+    {
+        // 空输入不产生事件，Parser 解析为 null
+        text = "null";
+    }
+    return parseText(text, false, out);
+}
+
+// 按 input 决定的位置切开，逐段喂给 StreamParser
+bool parseStream(std::string_view input, std::string &out)
+{
+    TreeBuilder builder;
+    StreamParser parser(builder);
+    // 切分位置只取决于输入本身，便于复现
+    size_t step = 1 + std::hash<std::string_view>()(input) % 7;
+    try
+    {
+        StreamParser::Status status = StreamParser::Status::NEED_MORE;
+        for (size_t pos = 0; pos < input.size() && status == StreamParser::Status::NEED_MORE; pos += step)
+        {
+            status = parser.feed(input.substr(pos, step));
+        }
+        if (status == StreamParser::Status::NEED_MORE)
+        {
+            parser.finish();
+        }
+    }
+    catch (const ParseException &)
+    {
+        return false;
+    }
+
+    JsonElement *root = builder.release();
+    out = root == nullptr ? "null" : root->dumps();
+    delete root;
+    return true;
+}
+
+// 完整展开 LazyDocument，写成 JSON 文本
+void writeLazy(LazyValue *value, std::string &out)
+{
+    switch (value->type())
+    {
+    case JsonElement::Type::JSON_OBJECT:
+    {
+        out += "{";
+        bool first = true;
+        for (auto &[key, member] : value->asObject())
+        {
+            std::string name;
+            Writer(name).onString(key);
+            out += first ? "" : ",";
+            out += name + ":";
+            writeLazy(member, out);
+            first = false;
+        }
+        out += "}";
+        break;
+    }
+    case JsonElement::Type::JSON_ARRAY:
+    {
+        out += "[";
+        bool first = true;
+        for (LazyValue *element : value->asArray())
+        {
+            out += first ? "" : ",";
+            writeLazy(element, out);
+            first = false;
+        }
+        out += "]";
+        break;
+    }
+    case JsonElement::Type::JSON_STRING:
+    {
+        Writer(out).onString(value->asString());
+        break;
+    }
+    case JsonElement::Type::JSON_NUMBER:
+    {
+        Number number;
+        number.type = value->numberType();
+        if (number.type == NumberType::INT64)
+        {
+            number.int64 = value->asInt64();
+        }
+        else if (number.type == NumberType::UINT64)
+        {
+            number.uint64 = value->asUInt64();
+        }
+        else
+        {
+            number.float64 = value->asNumber();
+        }
+        Writer(out).onNumber(number);
+        break;
+    }
+    case JsonElement::Type::JSON_BOOL:
+    {
+        out += value->asBool() ? "true" : "false";
+        break;
+    }
+    default:
+    {
+        out += "null";
+        break;
+    }
+    }
+}
+
+// Parser 读完第一个值之后停止，返回第一个值结束的位置
+size_t firstValueEnd(std::string_view input)
+{
+    JsonHandler handler;
+    Scanner scanner(input);
+    Reader reader;
+    reader.tryParse(scanner, handler);
+    return scanner.position();
+}
+
+// 在原始输入上完整展开 LazyDocument，出错时返回 false
+// 展开的每一层都要检查语法，因此出错的输入必须在展开过程中报错；重复的 key 会原样保留，因此再解析一次后比较
+bool parseLazy(std::string_view input, std::string &out)
+{
+    std::string text;
+    try
+    {
+        LazyDocument document(input);
+        writeLazy(document.root(), text);
+    }
+    catch (const std::logic_error &)
+    {
+        return false;
+    }
+    return parseText(text, false, out);
+}
+
+// 各个查询结果的 dumps() 拼在一起
+std::string joinDumps(const std::vector<JsonElement *> &elements)
+{
+    std::string out;
+    for (JsonElement *element : elements)
+    {
+        out += element->dumps();
+        out += "\n";
+    }
+    return out;
+}
+
+// 在规范化的文本上比较其他的读取方式
+void checkCanonical(std::string_view input, const std::string &canonical)
+{
+    std::string actual;
+
+    // 规范化是幂等的
+    if (!parseText(canonical, false, actual) || actual != canonical)
+    {
+        fail("dumps() round trip", input, canonical, actual);
+    }
+
+    // LazyDocument 完整展开
+    {
+        LazyDocument document(canonical);
+        actual.clear();
+        writeLazy(document.root(), actual);
+        if (actual != canonical)
+        {
+            fail("LazyDocument", input, canonical, actual);
+        }
+    }
+
+    Document document;
+    Parser{Scanner(std::string_view(canonical))}.parse(document);
+
+    // MessagePack 往返
+    {
+        std::string binary;
+        MsgpackWriter(binary).write(document.root());
+        Document copy;
+        MsgpackReader reader(binary);
+        reader.parse(copy);
+        actual = copy.root()->dumps();
+        if (actual != canonical || reader.position() != binary.size())
+        {
+            fail("MessagePack round trip", input, canonical, actual);
+        }
+    }
+
+    // 在 Scanner 上查询与在树上查询
+    for (const char *path : {"$.*", "$[0]", "$.*.*", "$[*][1]"})
+    {
+        JsonPath json_path = JsonPath::fromPath(path);
+        std::string expected = joinDumps(select(document.root(), json_path));
+
+        std::pmr::monotonic_buffer_resource arena;
+        Scanner scanner{std::string_view(canonical)};
+        actual = joinDumps(Query(json_path).select(scanner, &arena));
+        if (actual != expected)
+        {
+            fail(path, input, expected, actual);
+        }
+    }
+}
+
+// 检查一份输入
+void check(std::string_view input)
+{
+    std::string expected;
+    bool ok = parseText(input, false, expected);
+
+    std::string actual;
+    if (parseText(input, true, actual) != ok || (ok && actual != expected))
+    {
+        fail("indexed scan", input, ok ? expected : "<error>", actual);
+    }
+    actual.clear();
+    if (parseSax(input, actual) != ok || (ok && actual != expected))
+    {
+        fail("SAX + Writer", input, ok ? expected : "<error>", actual);
+    }
+    actual.clear();
+    if (parseStream(input, actual) != ok || (ok && actual != expected))
+    {
+        fail("StreamParser", input, ok ? expected : "<error>", actual);
+    }
+    // LazyDocument 先配对整份输入的括号，第一个值之后多余的内容也可能让它报错，因此成功时只展开 Parser 读过的部分
+    actual.clear();
+    if (parseLazy(ok ? input.substr(0, firstValueEnd(input)) : input, actual) != ok || (ok && actual != expected))
+    {
+        fail("LazyDocument (raw input)", input, ok ? expected : "<error>", actual);
+    }
+
+    if (ok)
+    {
+        checkCanonical(input, expected);
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    check(std::string_view(reinterpret_cast<const char *>(data), size));
+    return 0;
+}
+
+#ifndef USE_LIBFUZZER
+
+std::string readFile(const std::string &path)
+{
+    std::ifstream fin(path, std::ios::binary);
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    return ss.str();
+}
+
+// 随机修改一份输入：翻转、插入、删除字节，或拼接另一份输入的片段
+std::string mutate(const std::string &input, const std::vector<std::string> &corpus, std::mt19937_64 &rng)
+{
+    static const std::string TOKENS[] = {"{", "}", "[", "]", ",", ":", "\"", "\\", "\\u", "\\ud83d", "\\udc00",
+                                         "0", "-", ".", "e", "1e400", "true", "null", "\xe4\xb8\xad", "\xff", "\n"};
+    std::string output = input;
+    size_t edits = 1 + rng() % 4;
+    for (size_t i = 0; i < edits; i++)
+    {
+        size_t pos = output.empty() ? 0 : rng() % (output.size() + 1);
+        switch (rng() % 5)
+        {
+        case 0:
+            if (pos < output.size())
+            {
+                output[pos] = char(rng());
+            }
+            break;
+        case 1:
+            output.erase(pos, rng() % 8);
+            break;
+        case 2:
+        {
+            const std::string &token = TOKENS[rng() % (sizeof(TOKENS) / sizeof(TOKENS[0]))];
+            output.insert(pos, token);
+            break;
+        }
+        case 3:
+        {
+            // 重复一段，制造更深的嵌套与更长的数组
+            size_t length = rng() % 32;
+            output.insert(pos, output.substr(pos, length));
+            break;
+        }
+        default:
+        {
+            const std::string &other = corpus[rng() % corpus.size()];
+            size_t from = other.empty() ? 0 : rng() % other.size();
+            output.insert(pos, other.substr(from, rng() % 64));
+            break;
+        }
+        }
+    }
+    // 限制大小，保持每次检查足够快
+    if (output.size() > 4096)
+    {
+        output.resize(4096);
+    }
+    return output;
+}
+
+int main(int argc, const char **argv)
+{
+    // g++ -g -O1 -fsanitize=address,undefined -o fuzz fuzz.cpp scanner.cpp parser.cpp structuralIndex.cpp number.cpp reader.cpp treeBuilder.cpp streamParser.cpp writer.cpp query.cpp lazyDocument.cpp msgpack.cpp utf8.cpp -std=c++17 && ./fuzz 30 ../../test_resources
+    // libFuzzer: clang++ -g -O1 -fsanitize=fuzzer,address,undefined -DUSE_LIBFUZZER -o fuzz fuzz.cpp ...（同上） -std=c++17 && ./fuzz ../../test_resources
+    double seconds = argc > 1 ? std::stod(argv[1]) : 10;
+    std::string seeds = argc > 2 ? argv[2] : "../../test_resources";
+
+    // 种子：seeds 目录下的文件，NDJSON 按行拆开，再加上一些边界情况
+    std::vector<std::string> corpus = {"", "null", "[]", "{}", "-0", "1e308", "18446744073709551616", "\"\\ud83d\\ude00\"",
+                                       "{\"a\":1,\"a\":[2,{\"b\":null}]}", "[[[[[[[[[[]]]]]]]]]]"};
+    for (const auto &entry : std::filesystem::directory_iterator(seeds))
+    {
+        std::string content = readFile(entry.path().string());
+        corpus.push_back(content);
+        if (entry.path().extension() == ".ndjson")
+        {
+            std::istringstream lines(content);
+            std::string line;
+            while (std::getline(lines, line))
+            {
+                corpus.push_back(line);
+            }
+        }
+    }
+    for (const std::string &input : corpus)
+    {
+        check(input);
+    }
+
+    // 在时间预算内不断变异，种子固定，结果可以复现
+    std::mt19937_64 rng(20240601);
+    size_t runs = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds)
+    {
+        std::string input = mutate(corpus[rng() % corpus.size()], corpus, rng);
+        check(input);
+        // 能解析的变异结果加入语料，继续在其上变异
+        std::string canonical;
+        if (corpus.size() < 4096 && parseText(input, false, canonical))
+        {
+            corpus.push_back(input);
+        }
+        runs++;
+    }
+
+    printf("fuzz: %zu seeds, %zu runs, no mismatch\n", corpus.size(), runs);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string_view>
+#include "number.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        // SAX 风格的事件接口，Reader 每识别出一个值就回调一次，不构建 DOM
+        // string_view 参数只在回调期间有效，需要保留时自行拷贝
+        // 返回 false 表示不再需要后续事件，Reader 立即停止
+        class JsonHandler
+        {
+        public:
+            virtual ~JsonHandler() = default;
+
+            virtual bool onNull() { return true; }
+
+            virtual bool onBool(bool /*value*/) { return true; }
+
+            virtual bool onNumber(const Number &/*value*/) { return true; }
+
+            virtual bool onString(std::string_view /*value*/) { return true; }
+
+            // 对象中的 key，随后紧跟对应值的事件
+            virtual bool onKey(std::string_view /*key*/) { return true; }
+
+            virtual bool onStartObject() { return true; }
+
+            virtual bool onEndObject() { return true; }
+
+            virtual bool onStartArray() { return true; }
+
+            virtual bool onEndArray() { return true; }
+        };
+    }
+}
@@ -1,18 +1,20 @@
 #pragma once
 
 #include <string>
-#include <map>
-#include <sstream>
+#include <memory_resource>
+#include <type_traits>
 #include <vector>
 #include "error.h"
+#include "number.h"
+#include "jsonObject.h"
 
 namespace civitasv
 {
     namespace json
     {
-        class JsonElement;
-        using JsonObject = std::map<std::string, JsonElement *>;
-        using JsonArray = std::vector<JsonElement *>;
+        // 容器与字符串都使用 pmr 分配器，默认走堆，也可以分配在 Document 的 arena 上
+        // JsonString 与按插入顺序保存的 JsonObject 定义在 jsonObject.h 中
+        using JsonArray = std::pmr::vector<JsonElement *>;
 
         class JsonElement
         {
@@ -31,8 +33,10 @@ namespace civitasv
             {
                 JsonObject *value_object;
                 JsonArray *value_array;
-                std::string *value_string;
-                float value_number;
+                JsonString *value_string;
+                int64_t value_int;
+                uint64_t value_uint;
+                double value_double;
                 bool value_bool;
             };
 
@@ -46,22 +50,22 @@ namespace civitasv
                 {
                 case Type::JSON_OBJECT:
                 {
-                    this->value_.value_object = new std::map<std::string, JsonElement *>;
+                    this->value_.value_object = new JsonObject();
                     break;
                 }
                 case Type::JSON_ARRAY:
                 {
-                    this->value_.value_array = new std::vector<JsonElement *>();
+                    this->value_.value_array = new JsonArray();
                     break;
                 }
                 case Type::JSON_STRING:
                 {
-                    this->value_.value_string = new std::string("");
+                    this->value_.value_string = new JsonString();
                     break;
                 }
                 case Type::JSON_NUMBER:
                 {
-                    this->value_.value_number = 0;
+                    this->value_.value_int = 0;
                     break;
                 }
                 case Type::JSON_BOOL:
@@ -90,12 +94,19 @@ namespace civitasv
                 this->value(value_array);
             }
 
-            JsonElement(std::string *value_string) : type_(Type::JSON_STRING)
+            JsonElement(JsonString *value_string) : type_(Type::JSON_STRING)
             {
                 this->value(value_string);
             }
 
-            JsonElement(float value_number) : type_(Type::JSON_NUMBER)
+            // 任意整数或浮点数
+            template <class T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, int> = 0>
+            JsonElement(T value_number) : type_(Type::JSON_NUMBER)
+            {
+                this->value(value_number);
+            }
+
+            JsonElement(const Number &value_number) : type_(Type::JSON_NUMBER)
             {
                 this->value(value_number);
             }
@@ -105,7 +116,8 @@ namespace civitasv
                 this->value(value_bool);
             }
 
-            // 析构函数
+            // 析构函数，递归释放子节点
+            // 分配在 Document arena 上的节点不会调用析构，由 Document 整体释放
             ~JsonElement()
             {
                 if (this->type_ == Type::JSON_OBJECT)
@@ -128,7 +140,7 @@ namespace civitasv
                 }
                 else if (this->type_ == Type::JSON_STRING)
                 {
-                    std::string *val = this->value_.value_string;
+                    JsonString *val = this->value_.value_string;
                     delete val;
                 }
             }
@@ -151,16 +163,50 @@ namespace civitasv
                 this->value_.value_array = array;
             }
 
-            void value(std::string *val)
+            void value(JsonString *val)
             {
                 this->type_ = Type::JSON_STRING;
                 this->value_.value_string = val;
             }
 
-            void value(float number)
+            // 整数保持精确，浮点数保存为 double
+            template <class T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, int> = 0>
+            void value(T number)
             {
                 this->type_ = Type::JSON_NUMBER;
-                this->value_.value_number = number;
+                if constexpr (std::is_floating_point_v<T>)
+                {
+                    this->number_type_ = NumberType::DOUBLE;
+                    this->value_.value_double = double(number);
+                }
+                else if constexpr (std::is_signed_v<T>)
+                {
+                    this->number_type_ = NumberType::INT64;
+                    this->value_.value_int = int64_t(number);
+                }
+                else
+                {
+                    this->number_type_ = NumberType::UINT64;
+                    this->value_.value_uint = uint64_t(number);
+                }
+            }
+
+            void value(const Number &number)
+            {
+                this->type_ = Type::JSON_NUMBER;
+                this->number_type_ = number.type;
+                switch (number.type)
+                {
+                case NumberType::INT64:
+                    this->value_.value_int = number.int64;
+                    break;
+                case NumberType::UINT64:
+                    this->value_.value_uint = number.uint64;
+                    break;
+                default:
+                    this->value_.value_double = number.float64;
+                    break;
+                }
             }
 
             void value(bool value)
@@ -196,7 +242,7 @@ namespace civitasv
                 }
             }
 
-            std::string *asString()
+            JsonString *asString()
             {
                 if (this->type_ == Type::JSON_STRING)
                 {
@@ -209,116 +255,93 @@ namespace civitasv
                 }
             }
 
-            float asNumber()
+            // 数字转为 double，超过 2^53 的整数会丢失精度
+            double asNumber()
             {
                 if (this->type_ == Type::JSON_NUMBER)
                 {
-                    return this->value_.value_number;
+                    return this->number().toDouble();
                 }
                 else
                 {
                     error("Type of JsonElement isn't Number!");
-                    return 0.0f;
+                    return 0.0;
                 }
             }
 
-            bool asBool()
+            // 数字的具体类型
+            NumberType numberType()
             {
-                if (this->type_ == Type::JSON_BOOL)
-                {
-                    return this->value_.value_bool;
-                }
-                else
+                if (this->type_ != Type::JSON_NUMBER)
                 {
-                    error("Type of JsonElement isn't Boolean!");
-                    return false;
+                    error("Type of JsonElement isn't Number!");
                 }
+                return this->number_type_;
             }
 
-            // 转成字符串
-            std::string dumps()
+            // 精确的有符号整数
+            int64_t asInt64()
             {
-                std::stringstream ss;
-                switch (this->type_)
-                {
-                case Type::JSON_OBJECT:
+                if (this->type_ == Type::JSON_NUMBER && this->number_type_ == NumberType::INT64)
                 {
-                    ss << *(this->value_.value_object);
-                    break;
+                    return this->value_.value_int;
                 }
-                case Type::JSON_ARRAY:
+                if (this->type_ == Type::JSON_NUMBER && this->number_type_ == NumberType::UINT64 &&
+                    this->value_.value_uint <= uint64_t(INT64_MAX))
                 {
-                    ss << *(this->value_.value_array);
-                    break;
+                    return int64_t(this->value_.value_uint);
                 }
-                case Type::JSON_STRING:
-                {
-                    ss << '\"' << *(this->value_.value_string) << '\"';
-                    break;
-                }
-                case Type::JSON_NUMBER:
-                {
-                    ss << this->value_.value_number;
-                    break;
-                }
-                case Type::JSON_BOOL:
-                {
-                    ss << (this->value_.value_bool ? "true" : "false");
-                    break;
-                }
-                case Type::JSON_NULL:
+                error("Type of JsonElement isn't Int64!");
+                return 0;
+            }
+
+            // 精确的无符号整数
+            uint64_t asUInt64()
+            {
+                if (this->type_ == Type::JSON_NUMBER && this->number_type_ == NumberType::UINT64)
                 {
-                    ss << "null";
-                    break;
+                    return this->value_.value_uint;
                 }
-                default:
+                if (this->type_ == Type::JSON_NUMBER && this->number_type_ == NumberType::INT64 &&
+                    this->value_.value_int >= 0)
                 {
-                    break;
-                }
+                    return uint64_t(this->value_.value_int);
                 }
-
-                return ss.str();
+                error("Type of JsonElement isn't UInt64!");
+                return 0;
             }
 
-            // 重载 JsonObject
-            friend std::ostream &operator<<(std::ostream &os, const JsonObject &object)
+            bool asBool()
             {
-                os << "{";
-                for (auto iter = object.begin(); iter != object.end(); iter++)
+                if (this->type_ == Type::JSON_BOOL)
                 {
-                    os << "\"" << iter->first << "\""
-                       << ": " << iter->second->dumps();
-
-                    // 输出 ,
-                    if (iter != --object.end())
-                    {
-                        os << ",";
-                    }
+                    return this->value_.value_bool;
                 }
-                os << "}";
-
-                return os;
-            }
-
-            // 重载 JsonArray
-            friend std::ostream &operator<<(std::ostream &os, const JsonArray &array)
-            {
-                os << "[";
-                for (size_t i = 0; i < array.size(); i++)
+                else
                 {
-                    os << array[i]->dumps();
-                    if (i != array.size() - 1)
-                    {
-                        os << ",";
-                    }
+                    error("Type of JsonElement isn't Boolean!");
+                    return false;
                 }
-                os << "]";
+            }
+
+            // 转成字符串，indent 为 0 时输出紧凑格式，否则每层缩进 indent 个空格
+            // 定义在 writer.cpp 中，由 Writer 单趟写出
+            std::string dumps(int indent = 0);
 
-                return os;
+        private:
+            // 以 Number 的形式取出数字
+            Number number()
+            {
+                Number number;
+                number.type = this->number_type_;
+                number.uint64 = this->value_.value_uint;
+                return number;
             }
 
         private:
             Type type_;
+            // type_ 为 JSON_NUMBER 时数字的具体类型
+            NumberType number_type_ = NumberType::INT64;
             Value value_;
         };
     }
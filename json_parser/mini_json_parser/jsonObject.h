@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace civitasv
+{
+    namespace json
+    {
+        class JsonElement;
+        using JsonString = std::pmr::string;
+
+        // JSON 对象，按插入顺序保存键值对，key 直接存放在连续的数组中
+        // 成员较少时线性查找，超过 INDEX_THRESHOLD 个后额外维护一张开放寻址的哈希索引
+        // 与 std::pmr::map 的用法一致：operator[]、find、count、按 `auto &[key, value]` 遍历
+        class JsonObject
+        {
+        public:
+            using key_type = JsonString;
+            using mapped_type = JsonElement *;
+            using value_type = std::pair<JsonString, JsonElement *>;
+            using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+            using iterator = std::pmr::vector<value_type>::iterator;
+            using const_iterator = std::pmr::vector<value_type>::const_iterator;
+
+            // 成员超过该数量时建立哈希索引
+            static constexpr size_t INDEX_THRESHOLD = 8;
+
+            explicit JsonObject(allocator_type allocator = {}) : entries_(allocator), index_(allocator) {}
+
+            JsonObject(const JsonObject &) = delete;
+            JsonObject &operator=(const JsonObject &) = delete;
+
+            iterator begin() { return this->entries_.begin(); }
+
+            iterator end() { return this->entries_.end(); }
+
+            const_iterator begin() const { return this->entries_.begin(); }
+
+            const_iterator end() const { return this->entries_.end(); }
+
+            size_t size() const { return this->entries_.size(); }
+
+            bool empty() const { return this->entries_.empty(); }
+
+            allocator_type get_allocator() const { return this->entries_.get_allocator(); }
+
+            // 查找 key，不存在时返回 end()
+            iterator find(std::string_view key)
+            {
+                size_t pos = this->lookup(key);
+                return pos == NPOS ? this->end() : this->begin() + pos;
+            }
+
+            const_iterator find(std::string_view key) const
+            {
+                size_t pos = this->lookup(key);
+                return pos == NPOS ? this->end() : this->begin() + pos;
+            }
+
+            size_t count(std::string_view key) const
+            {
+                return this->lookup(key) == NPOS ? 0 : 1;
+            }
+
+            // 取出 key 对应的值，不存在时追加到末尾并初始化为 nullptr
+            // 重复的 key 保留第一次出现的位置
+            JsonElement *&operator[](std::string_view key)
+            {
+                size_t pos = this->lookup(key);
+                if (pos != NPOS)
+                {
+                    return this->entries_[pos].second;
+                }
+                this->entries_.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(nullptr));
+                this->indexBack();
+                return this->entries_.back().second;
+            }
+
+            void reserve(size_t size) { this->entries_.reserve(size); }
+
+        private:
+            static constexpr size_t NPOS = size_t(-1);
+
+            // 返回 key 在 entries_ 中的位置
+            size_t lookup(std::string_view key) const
+            {
+                if (this->index_.empty())
+                {
+                    for (size_t i = 0; i < this->entries_.size(); i++)
+                    {
+                        if (this->entries_[i].first == key)
+                        {
+                            return i;
+                        }
+                    }
+                    return NPOS;
+                }
+
+                // 线性探测，槽中保存位置 + 1，0 表示空槽
+                size_t mask = this->index_.size() - 1;
+                for (size_t slot = hash(key) & mask;; slot = (slot + 1) & mask)
+                {
+                    uint32_t pos = this->index_[slot];
+                    if (pos == 0)
+                    {
+                        return NPOS;
+                    }
+                    if (this->entries_[pos - 1].first == key)
+                    {
+                        return pos - 1;
+                    }
+                }
+            }
+
+            // 把最后追加的成员加入索引，负载超过一半时扩容
+            void indexBack()
+            {
+                size_t size = this->entries_.size();
+                if (size <= INDEX_THRESHOLD)
+                {
+                    return;
+                }
+                if (size * 2 > this->index_.size())
+                {
+                    this->rehash(this->index_.empty() ? 32 : this->index_.size() * 2);
+                    return;
+                }
+                this->insertIndex(size - 1);
+            }
+
+            // 以 capacity 个槽重建索引，capacity 为 2 的幂
+            void rehash(size_t capacity)
+            {
+                this->index_.assign(capacity, 0);
+                for (size_t i = 0; i < this->entries_.size(); i++)
+                {
+                    this->insertIndex(i);
+                }
+            }
+
+            void insertIndex(size_t pos)
+            {
+                size_t mask = this->index_.size() - 1;
+                size_t slot = hash(this->entries_[pos].first) & mask;
+                while (this->index_[slot] != 0)
+                {
+                    slot = (slot + 1) & mask;
+                }
+                this->index_[slot] = uint32_t(pos + 1);
+            }
+
+            static size_t hash(std::string_view key)
+            {
+                return std::hash<std::string_view>()(key);
+            }
+
+        private:
+            // 按插入顺序保存的成员
+            std::pmr::vector<value_type> entries_;
+            // 开放寻址的哈希索引，成员较少时为空
+            std::pmr::vector<uint32_t> index_;
+        };
+    }
+}
@@ -0,0 +1,375 @@
+#include <cstring>
+#include "lazyDocument.h"
+#include "structuralIndex.h"
+#include "error.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        using JsonTokenType = Scanner::JsonTokenType;
+        using Type = JsonElement::Type;
+
+        // 只建立结构索引，不产生节点
+        LazyDocument::LazyDocument(std::string_view source, size_t max_depth) : source_(source)
+        {
+            this->indexContainers(max_depth);
+
+            // 空输入解析为 null
+            Scanner scanner(source);
+            JsonTokenType token = scanner.scan();
+            if (token == JsonTokenType::END_OF_SOURCE)
+            {
+                token = JsonTokenType::LITERAL_NULL;
+            }
+            size_t container = 0;
+            this->root_ = this->create(scanner, token, 0, container);
+        }
+
+        // 配对括号，建立容器表
+        void LazyDocument::indexContainers(size_t max_depth)
+        {
+            // 所有 token 的起始位置，字符串中的括号不在其中
+            std::vector<uint32_t> tokens;
+            StructuralIndexer indexer;
+            if (!indexer.index(this->source_, tokens))
+            {
+                // 位置用 32 位保存，source 不能超过 4GB
+                error("LazyDocument: source is too large to index!");
+            }
+
+            // 未闭合的容器的序号与括号
+            std::vector<size_t> stack;
+            std::vector<char> brackets;
+            for (uint32_t position : tokens)
+            {
+                char c = this->source_[position];
+                if (c == '{' || c == '[')
+                {
+                    if (stack.size() >= max_depth)
+                    {
+                        error("Exceeded max nesting depth!");
+                    }
+                    stack.push_back(this->containers_.size());
+                    brackets.push_back(c);
+                    this->containers_.push_back(Container{0, 0});
+                }
+                else if (c == '}' || c == ']')
+                {
+                    if (stack.empty() || brackets.back() != (c == '}' ? '{' : '['))
+                    {
+                        error("Unbalanced brackets!");
+                    }
+                    this->containers_[stack.back()] = Container{size_t(position) + 1, this->containers_.size()};
+                    stack.pop_back();
+                    brackets.pop_back();
+                }
+            }
+
+            if (!stack.empty())
+            {
+                error("Unexpected end of source!");
+            }
+        }
+
+        // 为刚读到的 token 创建一个未展开的值
+        LazyValue *LazyDocument::create(Scanner &scanner, JsonTokenType token, size_t offset, size_t &container)
+        {
+            Type type;
+            switch (token)
+            {
+            case JsonTokenType::BEGAIN_OBJECT:
+            {
+                type = Type::JSON_OBJECT;
+                break;
+            }
+            case JsonTokenType::BEGAIN_ARRAY:
+            {
+                type = Type::JSON_ARRAY;
+                break;
+            }
+            case JsonTokenType::VALUE_STRING:
+            {
+                type = Type::JSON_STRING;
+                break;
+            }
+            case JsonTokenType::VALUE_NUMBER:
+            {
+                type = Type::JSON_NUMBER;
+                break;
+            }
+            case JsonTokenType::LITERAL_TRUE:
+            case JsonTokenType::LITERAL_FALSE:
+            {
+                type = Type::JSON_BOOL;
+                break;
+            }
+            case JsonTokenType::LITERAL_NULL:
+            {
+                type = Type::JSON_NULL;
+                break;
+            }
+            default:
+            {
+                error("Unexpected token in value!");
+                return nullptr;
+            }
+            }
+
+            void *p = this->arena_.allocate(sizeof(LazyValue), alignof(LazyValue));
+            LazyValue *value = new (p) LazyValue(this, offset, type, container);
+
+            // 容器留到访问时再展开，直接跳到结束位置；标量的值已经扫描出来，能直接保存的就不再重复扫描
+            switch (type)
+            {
+            case Type::JSON_OBJECT:
+            case Type::JSON_ARRAY:
+            {
+                scanner.seek(this->containers_[container].end);
+                container = this->containers_[container].next;
+                break;
+            }
+            case Type::JSON_STRING:
+            {
+                std::string_view view = scanner.getStringView();
+                if (view.data() >= this->source_.data() && view.data() + view.size() <= this->source_.data() + this->source_.size())
+                {
+                    value->value_string_ = view;
+                    value->decoded_ = true;
+                }
+                break;
+            }
+            case Type::JSON_NUMBER:
+            {
+                value->value_number_ = scanner.getNumber();
+                value->decoded_ = true;
+                break;
+            }
+            default:
+            {
+                value->value_bool_ = token == JsonTokenType::LITERAL_TRUE;
+                value->decoded_ = true;
+                break;
+            }
+            }
+            return value;
+        }
+
+        // 读取下一个 token，提前结束时报错
+        Scanner::JsonTokenType LazyDocument::next(Scanner &scanner)
+        {
+            JsonTokenType token = scanner.scan();
+            if (token == JsonTokenType::END_OF_SOURCE)
+            {
+                error("Unexpected end of source!");
+            }
+            return token;
+        }
+
+        // 指向 source 的字符串直接返回，否则拷贝到 arena 上
+        std::string_view LazyDocument::keep(std::string_view value)
+        {
+            if (value.data() >= this->source_.data() && value.data() + value.size() <= this->source_.data() + this->source_.size())
+            {
+                return value;
+            }
+            char *p = static_cast<char *>(this->arena_.allocate(value.size() + 1, 1));
+            memcpy(p, value.data(), value.size());
+            return std::string_view(p, value.size());
+        }
+
+        bool LazyValue::asBool()
+        {
+            this->expect(Type::JSON_BOOL, "Type of LazyValue isn't Boolean!");
+            return this->value_bool_;
+        }
+
+        double LazyValue::asNumber()
+        {
+            this->expect(Type::JSON_NUMBER, "Type of LazyValue isn't Number!");
+            return this->value_number_.toDouble();
+        }
+
+        NumberType LazyValue::numberType()
+        {
+            this->expect(Type::JSON_NUMBER, "Type of LazyValue isn't Number!");
+            return this->value_number_.type;
+        }
+
+        int64_t LazyValue::asInt64()
+        {
+            this->expect(Type::JSON_NUMBER, "Type of LazyValue isn't Int64!");
+            const Number &number = this->value_number_;
+            if (number.type == NumberType::INT64)
+            {
+                return number.int64;
+            }
+            if (number.type == NumberType::UINT64 && number.uint64 <= uint64_t(INT64_MAX))
+            {
+                return int64_t(number.uint64);
+            }
+            error("Type of LazyValue isn't Int64!");
+            return 0;
+        }
+
+        uint64_t LazyValue::asUInt64()
+        {
+            this->expect(Type::JSON_NUMBER, "Type of LazyValue isn't UInt64!");
+            const Number &number = this->value_number_;
+            if (number.type == NumberType::UINT64)
+            {
+                return number.uint64;
+            }
+            if (number.type == NumberType::INT64 && number.int64 >= 0)
+            {
+                return uint64_t(number.int64);
+            }
+            error("Type of LazyValue isn't UInt64!");
+            return 0;
+        }
+
+        std::string_view LazyValue::asString()
+        {
+            this->expect(Type::JSON_STRING, "Type of LazyValue isn't String!");
+            this->decode();
+            return this->value_string_;
+        }
+
+        LazyObject &LazyValue::asObject()
+        {
+            this->expect(Type::JSON_OBJECT, "Type of LazyValue isn't LazyObject!");
+            this->decode();
+            return *this->value_object_;
+        }
+
+        LazyArray &LazyValue::asArray()
+        {
+            this->expect(Type::JSON_ARRAY, "Type of LazyValue isn't LazyArray!");
+            this->decode();
+            return *this->value_array_;
+        }
+
+        // 对象中 key 对应的值，从后往前找，重复的 key 以后者为准
+        LazyValue *LazyValue::find(std::string_view key)
+        {
+            LazyObject &object = this->asObject();
+            for (auto iter = object.rbegin(); iter != object.rend(); ++iter)
+            {
+                if (iter->first == key)
+                {
+                    return iter->second;
+                }
+            }
+            return nullptr;
+        }
+
+        // 展开一层，同时检查这一层的语法
+        void LazyValue::decode()
+        {
+            if (this->decoded_)
+            {
+                return;
+            }
+
+            LazyDocument &document = *this->document_;
+            Scanner scanner(document.source_);
+            scanner.seek(this->offset_);
+            JsonTokenType token = scanner.scan();
+            // 第一个子容器紧跟在当前容器之后
+            size_t container = this->container_ + 1;
+
+            switch (this->type_)
+            {
+            case Type::JSON_OBJECT:
+            {
+                void *p = document.arena_.allocate(sizeof(LazyObject), alignof(LazyObject));
+                this->value_object_ = new (p) LazyObject(document.resource());
+
+                token = LazyDocument::next(scanner);
+                while (token != JsonTokenType::END_OBJECT)
+                {
+                    if (token != JsonTokenType::VALUE_STRING)
+                    {
+                        error("Key must be string!");
+                    }
+                    // key 在下一次 scan() 之前保存下来
+                    std::string_view key = document.keep(scanner.getStringView());
+                    if (LazyDocument::next(scanner) != JsonTokenType::NMAE_SEPARATOR)
+                    {
+                        error("Expected ':' in object!");
+                    }
+
+                    size_t offset = scanner.position();
+                    token = LazyDocument::next(scanner);
+                    this->value_object_->emplace_back(key, document.create(scanner, token, offset, container));
+
+                    token = LazyDocument::next(scanner);
+                    if (token == JsonTokenType::VALUE_SEPARATOR)
+                    {
+                        // ',' 之后必须是 key，不允许末尾多余的逗号
+                        token = LazyDocument::next(scanner);
+                        if (token != JsonTokenType::VALUE_STRING)
+                        {
+                            error("Key must be string!");
+                        }
+                    }
+                    else if (token != JsonTokenType::END_OBJECT)
+                    {
+                        error("Expected ',' in object!");
+                    }
+                }
+                break;
+            }
+            case Type::JSON_ARRAY:
+            {
+                void *p = document.arena_.allocate(sizeof(LazyArray), alignof(LazyArray));
+                this->value_array_ = new (p) LazyArray(document.resource());
+
+                size_t offset = scanner.position();
+                token = LazyDocument::next(scanner);
+                while (token != JsonTokenType::END_ARRAY)
+                {
+                    this->value_array_->push_back(document.create(scanner, token, offset, container));
+
+                    token = LazyDocument::next(scanner);
+                    if (token == JsonTokenType::VALUE_SEPARATOR)
+                    {
+                        offset = scanner.position();
+                        token = LazyDocument::next(scanner);
+                        // ',' 之后必须是值，不允许末尾多余的逗号
+                        if (token == JsonTokenType::END_ARRAY)
+                        {
+                            error("Unexpected token in value!");
+                        }
+                    }
+                    else if (token != JsonTokenType::END_ARRAY)
+                    {
+                        error("Expected ',' in array!");
+                    }
+                }
+                break;
+            }
+            case Type::JSON_STRING:
+            {
+                this->value_string_ = document.keep(scanner.getStringView());
+                break;
+            }
+            default:
+            {
+                break;
+            }
+            }
+
+            this->decoded_ = true;
+        }
+
+        // 类型不符时报错
+        void LazyValue::expect(Type type, const char *message)
+        {
+            if (this->type_ != type)
+            {
+                error(message);
+            }
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "jsonElement.h"
+#include "reader.h"
+#include "scanner.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        class LazyDocument;
+        class LazyValue;
+
+        // 展开后的对象成员与数组元素，成员本身仍未展开
+        using LazyObject = std::pmr::vector<std::pair<std::string_view, LazyValue *>>;
+        using LazyArray = std::pmr::vector<LazyValue *>;
+
+        // 按需展开的值，只记录在 source 中的位置
+        // 对象和数组在第一次 asObject()/asArray() 时才扫描出直接成员并检查语法，
+        // 含转义字符的字符串在第一次 asString() 时才解码，结果都缓存在 LazyDocument 的 arena 上
+        class LazyValue
+        {
+        public:
+            using Type = JsonElement::Type;
+
+            Type type() { return this->type_; }
+
+            bool asBool();
+
+            // 数字转为 double，超过 2^53 的整数会丢失精度
+            double asNumber();
+
+            NumberType numberType();
+
+            int64_t asInt64();
+
+            uint64_t asUInt64();
+
+            // 解码后的字符串，在 LazyDocument 与 source 有效期间一直有效
+            std::string_view asString();
+
+            LazyObject &asObject();
+
+            LazyArray &asArray();
+
+            // 对象中 key 对应的值，不存在时返回 nullptr，重复的 key 以后者为准
+            LazyValue *find(std::string_view key);
+
+        private:
+            friend class LazyDocument;
+
+            LazyValue(LazyDocument *document, size_t offset, Type type, size_t container)
+                : document_(document), offset_(offset), container_(container), type_(type) {}
+
+            // 第一次访问时展开
+            void decode();
+
+            // 类型不符时报错
+            void expect(Type type, const char *message);
+
+        private:
+            LazyDocument *document_;
+            // 值在 source 中的起始位置，之前可能有空白
+            size_t offset_;
+            // 对象或数组在 LazyDocument 容器表中的序号
+            size_t container_;
+            Type type_;
+            bool decoded_ = false;
+            bool value_bool_ = false;
+            Number value_number_;
+            std::string_view value_string_;
+            LazyObject *value_object_ = nullptr;
+            LazyArray *value_array_ = nullptr;
+        };
+
+        // 按需解析的文档：构造时只用 StructuralIndexer 建立结构索引，配对所有括号，
+        // 记录每个对象和数组的结束位置，不构建任何节点，也不解析其中的值
+        // 之后从 root() 开始，访问到哪一层才展开哪一层，未展开的子树直接跳到结束位置，
+        // 只读取少数字段时比完整解析快得多；语法错误在展开到所在的那一层时才会报出
+        // 借用 source，调用方需保证其在 LazyDocument 的整个生命周期内有效
+        // 展开会修改缓存，同一个 LazyDocument 不能在多个线程中同时访问
+        class LazyDocument
+        {
+        public:
+            // 括号不配对或超过最大嵌套深度时报错，source 为空时根节点为 null
+            explicit LazyDocument(std::string_view source, size_t max_depth = Reader::DEFAULT_MAX_DEPTH);
+
+            LazyDocument(const LazyDocument &) = delete;
+            LazyDocument &operator=(const LazyDocument &) = delete;
+
+            LazyValue *root() { return this->root_; }
+
+        private:
+            friend class LazyValue;
+
+            // 对象或数组的结束位置，以及其后下一个容器的序号
+            struct Container
+            {
+                size_t end;
+                size_t next;
+            };
+
+            // 配对括号，建立容器表，索引不可用时容器表为空
+            void indexContainers(size_t max_depth);
+
+            // 为 scanner 刚读到的 token 创建一个未展开的值，容器的内容直接跳过
+            // container 为下一个容器的序号，创建容器后指向其后的容器
+            LazyValue *create(Scanner &scanner, Scanner::JsonTokenType token, size_t offset, size_t &container);
+
+            // 读取下一个 token，提前结束时报错
+            static Scanner::JsonTokenType next(Scanner &scanner);
+
+            // 指向 source 的字符串直接返回，否则拷贝到 arena 上
+            std::string_view keep(std::string_view value);
+
+            std::pmr::memory_resource *resource() { return &this->arena_; }
+
+        private:
+            std::string_view source_;
+            std::pmr::monotonic_buffer_resource arena_;
+            // 按 { 或 [ 在文档中出现的顺序排列
+            std::vector<Container> containers_;
+            LazyValue *root_ = nullptr;
+        };
+    }
+}
@@ -1,7 +1,11 @@
+#include <chrono>
 #include <iostream>
 #include "cxxopts.hpp"
 #include "scanner.h"
 #include "parser.h"
+#include "streamParser.h"
+#include "treeBuilder.h"
+#include "ndjson.h"
 
 using namespace civitasv::json;
 
@@ -20,30 +24,104 @@ void print(const std::string &message)
 void repl()
 {
     // read, eval, print, loop
-    while (true)
+    while (std::cin)
     {
         print(">>> ");
-        std::string input = read();
 
-        Scanner scanner(input);
-        Parser parser(scanner);
+        try
+        {
+            // 一个值可以跨多行输入，逐行喂给分段解析器
+            TreeBuilder builder;
+            StreamParser parser(builder);
+            StreamParser::Status status = StreamParser::Status::NEED_MORE;
+            while (status == StreamParser::Status::NEED_MORE)
+            {
+                std::string input = read();
+                if (!std::cin)
+                {
+                    status = parser.finish();
+                    break;
+                }
 
-        JsonElement *res = parser.parse();
+                parser.feed(input);
+                status = parser.feed("\n");
+                if (status == StreamParser::Status::NEED_MORE)
+                {
+                    print("... ");
+                }
+            }
 
-        std::cout << ";Parse Result: " << res->dumps();
-        print("\n");
+            JsonElement *res = builder.release();
+            if (res != nullptr)
+            {
+                std::cout << ";Parse Result: " << res->dumps();
+                print("\n");
+            }
 
-        delete res;
+            delete res;
+        }
+        catch (const std::exception &e)
+        {
+            std::cout << ";Parse Error: " << e.what();
+            print("\n");
+        }
     }
 }
 
+// 多线程解析 ndjson 文件，按顺序输出每条记录，返回进程的退出码
+int parseFile(const std::string &filepath, size_t threads, bool quiet, bool skip)
+{
+    NdjsonParser parser(threads);
+    size_t errors = 0;
+    if (skip)
+    {
+        // 跳过解析失败的行，继续处理后面的记录
+        parser.onError([&](size_t /*offset*/, const ParseError &error)
+                       {
+                           std::cerr << filepath << ":" << error.line << ":" << error.column << ": " << error.message << '\n';
+                           errors++; });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t records = 0;
+    try
+    {
+        records = parser.parseFile(filepath, [&](size_t /*offset*/, JsonElement *record)
+                                   {
+                                       if (!quiet)
+                                       {
+                                           std::cout << record->dumps() << '\n';
+                                       } });
+    }
+    catch (const ParseException &e)
+    {
+        // 没有 -s 时遇到第一条坏记录就停止，格式与 -s 相同
+        const ParseError &error = e.error();
+        std::cerr << filepath << ":" << error.line << ":" << error.column << ": " << error.message << '\n';
+        return 1;
+    }
+    catch (const std::exception &e)
+    {
+        // 文件无法打开或映射，信息中已经带有路径
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "RECORDS: " << records << ", ERRORS: " << errors << ", THREADS: " << parser.threads() << ", TIME: " << seconds * 1000 << " ms\n";
+    return 0;
+}
+
 void parse(int argc, const char *argv[])
 {
     cxxopts::Options options(argv[0], "Json Parser");
 
     // clang-format off
     options.add_options()
-    ("f,file", "json file path", cxxopts::value<std::string>())
+    ("f,file", "ndjson file path, one record per line", cxxopts::value<std::string>())
+    ("t,threads", "parser threads, 0 for all cores", cxxopts::value<size_t>()->default_value("0"))
+    ("q,quiet", "only print the summary")
+    ("s,skip", "skip malformed records instead of stopping at the first one")
     ("h,help", "Print usage");
     // clang-format on
 
@@ -58,7 +136,7 @@ void parse(int argc, const char *argv[])
     {
         auto filepath = result["file"].as<std::string>();
         std::cout << "FILE PATH: " << filepath << '\n';
-        exit(0);
+        exit(parseFile(filepath, result["threads"].as<size_t>(), result.count("quiet") != 0, result.count("skip") != 0));
     }
 
     repl();
@@ -66,8 +144,8 @@ void parse(int argc, const char *argv[])
 
 int main(int argc, const char **argv)
 {
-    // g++ -o main main.cpp scanner.cpp parser.cpp -std=c++17 && ./main
-    // parse(argc, argv);
+    // g++ -O2 -pthread -o main main.cpp scanner.cpp parser.cpp structuralIndex.cpp number.cpp reader.cpp treeBuilder.cpp streamParser.cpp mappedFile.cpp ndjson.cpp writer.cpp utf8.cpp -std=c++17 && ./main -f ../../test_resources/test.ndjson
+    parse(argc, argv);
 
     return 0;
 }
@@ -0,0 +1,75 @@
+#include "mappedFile.h"
+#include "error.h"
+
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CIVITASV_JSON_MMAP 1
+#endif
+
+namespace civitasv
+{
+    namespace json
+    {
+        MappedFile::MappedFile(const std::string &path)
+        {
+#if CIVITASV_JSON_MMAP
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                error("can't open file: " + path);
+            }
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0)
+            {
+                ::close(fd);
+                error("can't stat file: " + path);
+            }
+
+            this->size_ = size_t(st.st_size);
+            // 空文件不能映射
+            if (this->size_ != 0)
+            {
+                void *data = ::mmap(nullptr, this->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data == MAP_FAILED)
+                {
+                    ::close(fd);
+                    error("can't mmap file: " + path);
+                }
+                // 顺序读取为主
+                ::madvise(data, this->size_, MADV_SEQUENTIAL);
+                this->data_ = static_cast<const char *>(data);
+                this->mapped_ = true;
+            }
+            ::close(fd);
+#else
+            std::ifstream fin(path, std::ios::binary);
+            if (!fin)
+            {
+                error("can't open file: " + path);
+            }
+            std::stringstream ss;
+            ss << fin.rdbuf();
+            this->buffer_ = ss.str();
+            this->data_ = this->buffer_.data();
+            this->size_ = this->buffer_.size();
+#endif
+        }
+
+        MappedFile::~MappedFile()
+        {
+#if CIVITASV_JSON_MMAP
+            if (this->mapped_)
+            {
+                ::munmap(const_cast<char *>(this->data_), this->size_);
+            }
+#endif
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 只读映射整个文件，配合 Scanner 的借用模式实现零拷贝解析
+        // POSIX 下使用 mmap，其他平台退回一次性读入内存
+        class MappedFile
+        {
+        public:
+            explicit MappedFile(const std::string &path);
+
+            ~MappedFile();
+
+            MappedFile(const MappedFile &) = delete;
+            MappedFile &operator=(const MappedFile &) = delete;
+
+            // 文件内容，在 MappedFile 销毁前有效
+            std::string_view view() const { return std::string_view(this->data_, this->size_); }
+
+            size_t size() const { return this->size_; }
+
+        private:
+            const char *data_ = nullptr;
+            size_t size_ = 0;
+            // 退回读入内存时的存储
+            std::string buffer_;
+            // 是否由 mmap 映射
+            bool mapped_ = false;
+        };
+    }
+}
@@ -0,0 +1,512 @@
+#include <algorithm>
+#include <cstring>
+#include "msgpack.h"
+#include "utf8.h"
+#include "error.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        using Type = JsonElement::Type;
+
+        // 编码整棵树
+        void MsgpackWriter::write(JsonElement *element)
+        {
+            // 显式栈中的一层，记录容器中下一个要写的位置
+            struct Frame
+            {
+                JsonElement *container;
+                JsonObject::iterator object;
+                size_t index;
+            };
+            std::vector<Frame> stack;
+
+            JsonElement *next = element;
+            while (true)
+            {
+                if (next != nullptr)
+                {
+                    switch (next->type())
+                    {
+                    case Type::JSON_OBJECT:
+                    {
+                        JsonObject *object = next->asObject();
+                        this->writeHeader(0x80, 0xde, 0xdf, object->size());
+                        stack.push_back({next, object->begin(), 0});
+                        break;
+                    }
+                    case Type::JSON_ARRAY:
+                    {
+                        this->writeHeader(0x90, 0xdc, 0xdd, next->asArray()->size());
+                        stack.push_back({next, {}, 0});
+                        break;
+                    }
+                    case Type::JSON_STRING:
+                    {
+                        this->writeString(*next->asString());
+                        break;
+                    }
+                    case Type::JSON_NUMBER:
+                    {
+                        this->writeNumber(next);
+                        break;
+                    }
+                    case Type::JSON_BOOL:
+                    {
+                        this->out_.push_back(next->asBool() ? char(0xc3) : char(0xc2));
+                        break;
+                    }
+                    default:
+                    {
+                        this->out_.push_back(char(0xc0));
+                        break;
+                    }
+                    }
+                    next = nullptr;
+                }
+
+                if (stack.empty())
+                {
+                    break;
+                }
+
+                Frame &frame = stack.back();
+                if (frame.container->type() == Type::JSON_OBJECT)
+                {
+                    if (frame.object == frame.container->asObject()->end())
+                    {
+                        stack.pop_back();
+                        continue;
+                    }
+                    this->writeString(frame.object->first);
+                    next = frame.object->second;
+                    ++frame.object;
+                }
+                else
+                {
+                    JsonArray *array = frame.container->asArray();
+                    if (frame.index == array->size())
+                    {
+                        stack.pop_back();
+                        continue;
+                    }
+                    next = (*array)[frame.index++];
+                }
+            }
+        }
+
+        // 整数选用最短的编码
+        void MsgpackWriter::writeNumber(JsonElement *element)
+        {
+            NumberType type = element->numberType();
+            if (type == NumberType::DOUBLE)
+            {
+                double value = element->asNumber();
+                uint64_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                this->out_.push_back(char(0xcb));
+                this->writeBigEndian(bits, 8);
+                return;
+            }
+
+            if (type == NumberType::UINT64 || element->asInt64() >= 0)
+            {
+                uint64_t value = element->asUInt64();
+                if (value < 0x80)
+                {
+                    // positive fixint
+                    this->out_.push_back(char(value));
+                }
+                else if (value <= 0xff)
+                {
+                    this->out_.push_back(char(0xcc));
+                    this->writeBigEndian(value, 1);
+                }
+                else if (value <= 0xffff)
+                {
+                    this->out_.push_back(char(0xcd));
+                    this->writeBigEndian(value, 2);
+                }
+                else if (value <= 0xffffffff)
+                {
+                    this->out_.push_back(char(0xce));
+                    this->writeBigEndian(value, 4);
+                }
+                else
+                {
+                    this->out_.push_back(char(0xcf));
+                    this->writeBigEndian(value, 8);
+                }
+                return;
+            }
+
+            int64_t value = element->asInt64();
+            if (value >= -32)
+            {
+                // negative fixint
+                this->out_.push_back(char(value));
+            }
+            else if (value >= INT8_MIN)
+            {
+                this->out_.push_back(char(0xd0));
+                this->writeBigEndian(uint64_t(value), 1);
+            }
+            else if (value >= INT16_MIN)
+            {
+                this->out_.push_back(char(0xd1));
+                this->writeBigEndian(uint64_t(value), 2);
+            }
+            else if (value >= INT32_MIN)
+            {
+                this->out_.push_back(char(0xd2));
+                this->writeBigEndian(uint64_t(value), 4);
+            }
+            else
+            {
+                this->out_.push_back(char(0xd3));
+                this->writeBigEndian(uint64_t(value), 8);
+            }
+        }
+
+        void MsgpackWriter::writeString(std::string_view value)
+        {
+            size_t size = value.size();
+            if (size < 32)
+            {
+                // fixstr
+                this->out_.push_back(char(0xa0 | size));
+            }
+            else if (size <= 0xff)
+            {
+                this->out_.push_back(char(0xd9));
+                this->writeBigEndian(size, 1);
+            }
+            else if (size <= 0xffff)
+            {
+                this->out_.push_back(char(0xda));
+                this->writeBigEndian(size, 2);
+            }
+            else if (size <= 0xffffffff)
+            {
+                this->out_.push_back(char(0xdb));
+                this->writeBigEndian(size, 4);
+            }
+            else
+            {
+                error("MessagePack: string is too long!");
+            }
+            this->out_.append(value.data(), size);
+        }
+
+        // 数组或 map 的头部
+        void MsgpackWriter::writeHeader(uint8_t fix, uint8_t code16, uint8_t code32, size_t size)
+        {
+            if (size < 16)
+            {
+                this->out_.push_back(char(fix | size));
+            }
+            else if (size <= 0xffff)
+            {
+                this->out_.push_back(char(code16));
+                this->writeBigEndian(size, 2);
+            }
+            else if (size <= 0xffffffff)
+            {
+                this->out_.push_back(char(code32));
+                this->writeBigEndian(size, 4);
+            }
+            else
+            {
+                error("MessagePack: container is too large!");
+            }
+        }
+
+        // 大端序写入
+        void MsgpackWriter::writeBigEndian(uint64_t value, int bytes)
+        {
+            char buffer[8];
+            for (int i = bytes - 1; i >= 0; i--)
+            {
+                buffer[i] = char(value & 0xff);
+                value >>= 8;
+            }
+            this->out_.append(buffer, bytes);
+        }
+
+        // 读取一个完整的值
+        bool MsgpackReader::parse(JsonHandler &handler)
+        {
+            this->pos_ = 0;
+            this->stack_.clear();
+
+            do
+            {
+                if (!this->stack_.empty())
+                {
+                    Frame &top = this->stack_.back();
+                    // 容器中的成员都已读完
+                    if (top.remaining == 0)
+                    {
+                        bool object = top.object;
+                        this->stack_.pop_back();
+                        if (!(object ? handler.onEndObject() : handler.onEndArray()))
+                        {
+                            return false;
+                        }
+                        continue;
+                    }
+                    top.remaining--;
+
+                    // 对象中先读 key
+                    if (top.object)
+                    {
+                        std::string_view key;
+                        if (!this->readString(key))
+                        {
+                            error("MessagePack: map key must be string!");
+                        }
+                        if (!handler.onKey(key))
+                        {
+                            return false;
+                        }
+                    }
+                }
+
+                if (!this->value(handler))
+                {
+                    return false;
+                }
+            } while (!this->stack_.empty());
+
+            return true;
+        }
+
+        // 构建 JsonElement 树
+        JsonElement *MsgpackReader::parse()
+        {
+            TreeBuilder builder;
+            this->builder_ = &builder;
+            try
+            {
+                this->parse(builder);
+            }
+            catch (...)
+            {
+                this->builder_ = nullptr;
+                throw;
+            }
+            this->builder_ = nullptr;
+            return builder.release();
+        }
+
+        // 构建到 document 的 arena 上
+        void MsgpackReader::parse(Document &document)
+        {
+            document.clear();
+            try
+            {
+                TreeBuilder builder(document.resource());
+                this->builder_ = &builder;
+                this->parse(builder);
+                this->builder_ = nullptr;
+                document.root(builder.release());
+            }
+            catch (...)
+            {
+                this->builder_ = nullptr;
+                document.clear();
+                throw;
+            }
+        }
+
+        // 读取一个值
+        bool MsgpackReader::value(JsonHandler &handler)
+        {
+            need(1);
+            uint8_t code = uint8_t(this->data_[this->pos_++]);
+
+            // 带长度的 fix 类型
+            if (code <= 0x7f)
+            {
+                Number number;
+                number.int64 = code;
+                return handler.onNumber(number);
+            }
+            if (code >= 0xe0)
+            {
+                Number number;
+                number.int64 = int8_t(code);
+                return handler.onNumber(number);
+            }
+            if ((code & 0xf0) == 0x80)
+            {
+                return this->start(handler, true, code & 0x0f);
+            }
+            if ((code & 0xf0) == 0x90)
+            {
+                return this->start(handler, false, code & 0x0f);
+            }
+            if ((code & 0xe0) == 0xa0 || code == 0xd9 || code == 0xda || code == 0xdb)
+            {
+                this->pos_--;
+                std::string_view value;
+                this->readString(value);
+                return handler.onString(value);
+            }
+
+            Number number;
+            switch (code)
+            {
+            case 0xc0:
+            {
+                return handler.onNull();
+            }
+            case 0xc2:
+            {
+                return handler.onBool(false);
+            }
+            case 0xc3:
+            {
+                return handler.onBool(true);
+            }
+            case 0xca:
+            {
+                uint32_t bits = uint32_t(this->readBigEndian(4));
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                number.type = NumberType::DOUBLE;
+                number.float64 = value;
+                return handler.onNumber(number);
+            }
+            case 0xcb:
+            {
+                uint64_t bits = this->readBigEndian(8);
+                number.type = NumberType::DOUBLE;
+                memcpy(&number.float64, &bits, sizeof(bits));
+                return handler.onNumber(number);
+            }
+            case 0xcc:
+            case 0xcd:
+            case 0xce:
+            case 0xcf:
+            {
+                // uint 8/16/32/64，放得进 int64 的保存为 INT64，与文本解析一致
+                uint64_t value = this->readBigEndian(1 << (code - 0xcc));
+                if (value <= uint64_t(INT64_MAX))
+                {
+                    number.int64 = int64_t(value);
+                }
+                else
+                {
+                    number.type = NumberType::UINT64;
+                    number.uint64 = value;
+                }
+                return handler.onNumber(number);
+            }
+            case 0xd0:
+            case 0xd1:
+            case 0xd2:
+            case 0xd3:
+            {
+                // int 8/16/32/64，符号扩展
+                int bytes = 1 << (code - 0xd0);
+                uint64_t value = this->readBigEndian(bytes);
+                int shift = 64 - bytes * 8;
+                number.int64 = int64_t(value << shift) >> shift;
+                return handler.onNumber(number);
+            }
+            case 0xdc:
+            case 0xdd:
+            {
+                return this->start(handler, false, this->readBigEndian(code == 0xdc ? 2 : 4));
+            }
+            case 0xde:
+            case 0xdf:
+            {
+                return this->start(handler, true, this->readBigEndian(code == 0xde ? 2 : 4));
+            }
+            default:
+            {
+                // bin、ext 等无法表示为 JSON 的类型
+                error("MessagePack: unsupported type!");
+                return false;
+            }
+            }
+        }
+
+        // 读取一个字符串
+        bool MsgpackReader::readString(std::string_view &value)
+        {
+            need(1);
+            uint8_t code = uint8_t(this->data_[this->pos_]);
+            size_t size;
+            if ((code & 0xe0) == 0xa0)
+            {
+                this->pos_++;
+                size = code & 0x1f;
+            }
+            else if (code == 0xd9 || code == 0xda || code == 0xdb)
+            {
+                this->pos_++;
+                size = this->readBigEndian(1 << (code - 0xd9));
+            }
+            else
+            {
+                return false;
+            }
+
+            need(size);
+            value = this->data_.substr(this->pos_, size);
+            this->pos_ += size;
+            // 与文本解析一样，保证交给 handler 的字符串是合法的 UTF-8
+            if (!validateUtf8(value))
+            {
+                error("MessagePack: invalid UTF-8 string!");
+            }
+            return true;
+        }
+
+        // 进入一层容器
+        bool MsgpackReader::start(JsonHandler &handler, bool object, size_t size)
+        {
+            if (this->stack_.size() >= this->max_depth_)
+            {
+                error("Exceeded max nesting depth!");
+            }
+            this->stack_.push_back(Frame{object, size});
+            if (!(object ? handler.onStartObject() : handler.onStartArray()))
+            {
+                return false;
+            }
+            if (this->builder_ != nullptr)
+            {
+                // 每个成员至少占一个字节，成员数不可信时不会因此预留过多
+                this->builder_->reserve(std::min(size, this->data_.size() - this->pos_));
+            }
+            return true;
+        }
+
+        // 确保还有 size 字节可读
+        void MsgpackReader::need(size_t size)
+        {
+            if (size > this->data_.size() - this->pos_)
+            {
+                error("MessagePack: unexpected end of data!");
+            }
+        }
+
+        // 大端序读取
+        uint64_t MsgpackReader::readBigEndian(int bytes)
+        {
+            need(bytes);
+            uint64_t value = 0;
+            for (int i = 0; i < bytes; i++)
+            {
+                value = (value << 8) | uint8_t(this->data_[this->pos_ + i]);
+            }
+            this->pos_ += bytes;
+            return value;
+        }
+    }
+}
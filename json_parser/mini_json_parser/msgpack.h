@@ -0,0 +1,95 @@
+#pragma once
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document.h"
+#include "handler.h"
+#include "jsonElement.h"
+#include "reader.h"
+#include "treeBuilder.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 将 JsonElement 树编码为 MessagePack，追加到 out 中
+        // 整数选用能放下的最短编码，浮点数一律编码为 float64，保证与文本解析的结果一致
+        class MsgpackWriter
+        {
+        public:
+            explicit MsgpackWriter(std::string &out) : out_(out) {}
+
+            // 编码整棵树，使用显式栈，不受嵌套深度限制
+            void write(JsonElement *element);
+
+        private:
+            void writeNumber(JsonElement *element);
+
+            void writeString(std::string_view value);
+
+            // 数组或 map 的头部
+            void writeHeader(uint8_t fix, uint8_t code16, uint8_t code32, size_t size);
+
+            // 大端序写入
+            void writeBigEndian(uint64_t value, int bytes);
+
+        private:
+            std::string &out_;
+        };
+
+        // 读取 MessagePack 数据，依次回调 handler，与 Reader 产生的事件一致
+        // 直接在 data 上读取，字符串以指向 data 的 string_view 交给 handler，不拷贝，
+        // data 可以是 MappedFile 映射的文件；只接受能表示为 JSON 的类型，map 的 key 必须是字符串
+        class MsgpackReader
+        {
+        public:
+            explicit MsgpackReader(std::string_view data, size_t max_depth = Reader::DEFAULT_MAX_DEPTH)
+                : data_(data), max_depth_(max_depth) {}
+
+            // 读取一个完整的值，返回 false 表示 handler 中途要求停止
+            bool parse(JsonHandler &handler);
+
+            // 构建 JsonElement 树，由调用方释放
+            JsonElement *parse();
+
+            // 构建到 document 的 arena 上
+            void parse(Document &document);
+
+            // 已经读取的字节数
+            size_t position() { return this->pos_; }
+
+        private:
+            // 显式栈中的一层，remaining 为尚未读取的成员数
+            struct Frame
+            {
+                bool object;
+                size_t remaining;
+            };
+
+            // 读取一个值，容器只读取头部并压栈
+            bool value(JsonHandler &handler);
+
+            // 读取一个字符串，不是字符串时返回 false
+            bool readString(std::string_view &value);
+
+            // 进入一层容器：压栈并回调 handler，构建树时按头部中的成员数预留空间
+            bool start(JsonHandler &handler, bool object, size_t size);
+
+            // 确保还有 size 字节可读
+            void need(size_t size);
+
+            // 大端序读取
+            uint64_t readBigEndian(int bytes);
+
+        private:
+            std::string_view data_;
+            size_t pos_ = 0;
+            size_t max_depth_;
+            std::vector<Frame> stack_;
+            // 构建树时使用的 builder，其他 handler 时为空
+            TreeBuilder *builder_ = nullptr;
+        };
+    }
+}
@@ -0,0 +1,328 @@
+#include "ndjson.h"
+#include "mappedFile.h"
+#include "reader.h"
+#include "scanner.h"
+#include "treeBuilder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+
+namespace civitasv
+{
+    namespace json
+    {
+        NdjsonParser::NdjsonParser(size_t threads) : threads_(threads)
+        {
+            if (this->threads_ == 0)
+            {
+                this->threads_ = std::max<size_t>(1, std::thread::hardware_concurrency());
+            }
+        }
+
+        // 按行对齐切分
+        std::vector<std::string_view> NdjsonParser::split(std::string_view source, std::vector<size_t> *lines)
+        {
+            std::vector<std::string_view> chunks;
+            size_t begin = 0;
+            size_t line = 1;
+            while (begin < source.size())
+            {
+                size_t end = begin + this->chunk_size_;
+                if (end >= source.size())
+                {
+                    end = source.size();
+                }
+                else
+                {
+                    // 对齐到下一个行尾之后
+                    end = source.find('\n', end);
+                    end = end == std::string_view::npos ? source.size() : end + 1;
+                }
+                chunks.push_back(source.substr(begin, end - begin));
+                if (lines != nullptr)
+                {
+                    lines->push_back(line);
+                    line += std::count(chunks.back().begin(), chunks.back().end(), '\n');
+                }
+                begin = end;
+            }
+            return chunks;
+        }
+
+        // 解析一个分块中的所有记录
+        size_t NdjsonParser::parseChunk(std::string_view source, std::string_view chunk, size_t line, std::pmr::memory_resource *resource,
+                                        const std::function<void(size_t, JsonElement *)> &callback,
+                                        const std::function<void(size_t, const ParseError &)> &on_error)
+        {
+            size_t base = chunk.data() - source.data();
+            Reader reader;
+            TreeBuilder builder(resource);
+            size_t count = 0;
+            size_t pos = 0;
+            // 当前记录在分块中是第几行，从 0 开始
+            size_t row = 0;
+            while (pos < chunk.size())
+            {
+                size_t end = chunk.find('\n', pos);
+                if (end == std::string_view::npos)
+                {
+                    end = chunk.size();
+                }
+
+                // 借用模式，直接在输入上扫描；出错时不抛出异常，坏记录只需要跳到下一行
+                Scanner scanner(chunk.substr(pos, end - pos));
+                ParseError error = reader.tryParse(scanner, builder);
+                if (!error && !reader.empty() && scanner.tryScan() != Scanner::JsonTokenType::END_OF_SOURCE)
+                {
+                    error = scanner.makeError(ErrorCode::UNEXPECTED_TOKEN, "Unexpected data after record!", scanner.tokenPosition());
+                }
+
+                if (error)
+                {
+                    // 记录只占一行，列号不变，偏移与行号换算为相对于整个输入
+                    if (line == 0)
+                    {
+                        line = 1 + std::count(source.data(), chunk.data(), '\n');
+                    }
+                    error.offset += base + pos;
+                    error.line = line + row;
+                    if (!on_error)
+                    {
+                        throw ParseException(error);
+                    }
+                    // 丢弃构建到一半的记录，arena 上的内存随分块一起释放
+                    builder.reset(resource);
+                    on_error(base + pos, error);
+                }
+                // 跳过空行
+                else if (!reader.empty())
+                {
+                    callback(base + pos, builder.release());
+                    count++;
+                }
+
+                pos = end + 1;
+                row++;
+            }
+            return count;
+        }
+
+        // 按顺序回调
+        size_t NdjsonParser::parse(std::string_view source, const RecordHandler &handler)
+        {
+            // 每个分块的解析结果
+            struct Result
+            {
+                std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+                // 解析失败的记录为 nullptr，对应的错误依次保存在 errors 中
+                std::vector<std::pair<size_t, JsonElement *>> records;
+                std::vector<ParseError> errors;
+                std::exception_ptr error;
+                bool done = false;
+            };
+
+            // 恢复模式下事先计算每个分块的起始行号
+            std::vector<size_t> lines;
+            std::vector<std::string_view> chunks = this->split(source, this->error_handler_ ? &lines : nullptr);
+            std::vector<Result> results(chunks.size());
+            // 最多领先已回调的分块这么多，避免解析结果堆积
+            size_t window = this->threads_ * 2;
+
+            std::mutex mutex;
+            std::condition_variable cv;
+            size_t next = 0;
+            size_t delivered = 0;
+            bool stop = false;
+
+            auto worker = [&]()
+            {
+                while (true)
+                {
+                    size_t index;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        cv.wait(lock, [&]()
+                                { return stop || next >= chunks.size() || next < delivered + window; });
+                        if (stop || next >= chunks.size())
+                        {
+                            return;
+                        }
+                        index = next++;
+                    }
+
+                    Result &result = results[index];
+                    result.arena = std::make_unique<std::pmr::monotonic_buffer_resource>(chunks[index].size());
+                    try
+                    {
+                        std::function<void(size_t, const ParseError &)> on_error;
+                        if (this->error_handler_)
+                        {
+                            on_error = [&](size_t offset, const ParseError &error)
+                            {
+                                result.records.emplace_back(offset, nullptr);
+                                result.errors.push_back(error);
+                            };
+                        }
+                        parseChunk(source, chunks[index], lines.empty() ? 0 : lines[index], result.arena.get(),
+                                   [&](size_t offset, JsonElement *record)
+                                   { result.records.emplace_back(offset, record); },
+                                   on_error);
+                    }
+                    catch (...)
+                    {
+                        result.error = std::current_exception();
+                    }
+
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        result.done = true;
+                    }
+                    cv.notify_all();
+                }
+            };
+
+            std::vector<std::thread> workers;
+            size_t count = std::min(this->threads_, chunks.size());
+            for (size_t i = 0; i < count; i++)
+            {
+                workers.emplace_back(worker);
+            }
+
+            size_t total = 0;
+            std::exception_ptr failure;
+            try
+            {
+                // 在调用线程上按顺序回调
+                for (size_t i = 0; i < chunks.size(); i++)
+                {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        cv.wait(lock, [&]()
+                                { return results[i].done; });
+                    }
+
+                    Result &result = results[i];
+                    if (result.error)
+                    {
+                        std::rethrow_exception(result.error);
+                    }
+                    size_t error = 0;
+                    for (auto &[offset, record] : result.records)
+                    {
+                        if (record == nullptr)
+                        {
+                            this->error_handler_(offset, result.errors[error++]);
+                            continue;
+                        }
+                        handler(offset, record);
+                    }
+                    total += result.records.size() - result.errors.size();
+                    // 整块释放
+                    result.records = {};
+                    result.errors = {};
+                    result.arena.reset();
+
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        delivered = i + 1;
+                    }
+                    cv.notify_all();
+                }
+            }
+            catch (...)
+            {
+                failure = std::current_exception();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            cv.notify_all();
+            for (auto &thread : workers)
+            {
+                thread.join();
+            }
+
+            if (failure)
+            {
+                std::rethrow_exception(failure);
+            }
+            return total;
+        }
+
+        // 每个线程各自回调
+        size_t NdjsonParser::parseUnordered(std::string_view source, const ThreadRecordHandler &handler)
+        {
+            std::vector<size_t> lines;
+            std::vector<std::string_view> chunks = this->split(source, this->error_handler_ ? &lines : nullptr);
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> total{0};
+            std::atomic<bool> stop{false};
+            std::mutex mutex;
+            std::exception_ptr failure;
+
+            auto worker = [&](size_t thread)
+            {
+                std::pmr::monotonic_buffer_resource arena;
+                while (!stop)
+                {
+                    size_t index = next++;
+                    if (index >= chunks.size())
+                    {
+                        return;
+                    }
+
+                    try
+                    {
+                        total += parseChunk(source, chunks[index], lines.empty() ? 0 : lines[index], &arena,
+                                            [&](size_t offset, JsonElement *record)
+                                            { handler(thread, offset, record); },
+                                            this->error_handler_);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!failure)
+                        {
+                            failure = std::current_exception();
+                        }
+                        stop = true;
+                    }
+                    // 一个分块处理完后整体释放
+                    arena.release();
+                }
+            };
+
+            std::vector<std::thread> workers;
+            size_t count = std::min(this->threads_, chunks.size());
+            for (size_t i = 0; i < count; i++)
+            {
+                workers.emplace_back(worker, i);
+            }
+            for (auto &thread : workers)
+            {
+                thread.join();
+            }
+
+            if (failure)
+            {
+                std::rethrow_exception(failure);
+            }
+            return total;
+        }
+
+        // mmap 整个文件后按顺序回调
+        size_t NdjsonParser::parseFile(const std::string &path, const RecordHandler &handler)
+        {
+            MappedFile file(path);
+            return this->parse(file.view(), handler);
+        }
+    }
+}
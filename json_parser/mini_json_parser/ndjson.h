@@ -0,0 +1,73 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "jsonElement.h"
+#include "error.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        // NDJSON / JSON Lines 批量解析器，每行一条记录
+        // 输入按行对齐切成若干分块，由多个线程并行解析，每个分块的记录分配在各自的 arena 上
+        class NdjsonParser
+        {
+        public:
+            // 按原始顺序在调用线程上回调，offset 为记录在输入中的字节偏移
+            // record 只在回调期间有效
+            using RecordHandler = std::function<void(size_t offset, JsonElement *record)>;
+
+            // 在工作线程上直接回调，不保证顺序，thread 为工作线程编号，回调需要线程安全
+            using ThreadRecordHandler = std::function<void(size_t thread, size_t offset, JsonElement *record)>;
+
+            // 解析失败的记录，offset 为记录在输入中的字节偏移，error 的位置相对于整个输入
+            using ErrorHandler = std::function<void(size_t offset, const ParseError &error)>;
+
+            // 默认的分块大小
+            static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+            // threads 为 0 时使用硬件线程数
+            explicit NdjsonParser(size_t threads = 0);
+
+            size_t threads() { return this->threads_; }
+
+            // 每个分块的目标大小，实际大小会对齐到行尾
+            size_t chunkSize() { return this->chunk_size_; }
+
+            void chunkSize(size_t bytes) { this->chunk_size_ = bytes == 0 ? 1 : bytes; }
+
+            // 恢复模式：解析失败的记录交给 handler 后跳过，继续解析下一行，不抛出异常
+            // parse() 中与记录一起按顺序在调用线程上回调，parseUnordered() 中在工作线程上回调，需要线程安全
+            // 传入空的 handler 时恢复为默认行为：任意一条记录解析失败时抛出 ParseException
+            void onError(ErrorHandler handler) { this->error_handler_ = std::move(handler); }
+
+            // 按顺序回调，返回解析成功的记录条数
+            size_t parse(std::string_view source, const RecordHandler &handler);
+
+            // 每个线程各自回调，返回解析成功的记录条数
+            size_t parseUnordered(std::string_view source, const ThreadRecordHandler &handler);
+
+            // mmap 整个文件后按顺序回调
+            size_t parseFile(const std::string &path, const RecordHandler &handler);
+
+        private:
+            // 按行对齐切分，lines 不为空时同时记录每个分块第一行的行号
+            std::vector<std::string_view> split(std::string_view source, std::vector<size_t> *lines);
+
+            // 解析 source 中一个分块的所有记录，返回解析成功的记录条数
+            // line 为分块第一行的行号，未知时为 0，只在出错时才计算
+            // on_error 为空时遇到错误抛出 ParseException
+            static size_t parseChunk(std::string_view source, std::string_view chunk, size_t line, std::pmr::memory_resource *resource,
+                                     const std::function<void(size_t, JsonElement *)> &callback,
+                                     const std::function<void(size_t, const ParseError &)> &on_error);
+
+        private:
+            size_t threads_;
+            size_t chunk_size_ = DEFAULT_CHUNK_SIZE;
+            ErrorHandler error_handler_;
+        };
+    }
+}
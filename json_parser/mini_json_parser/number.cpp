@@ -0,0 +1,163 @@
+#include "number.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace civitasv
+{
+    namespace json
+    {
+        namespace
+        {
+            inline bool isDigit(char c)
+            {
+                return c >= '0' && c <= '9';
+            }
+
+            // 超出 double 范围等少见情况交给 strtod
+            double slowParseDouble(const char *first, const char *last)
+            {
+                std::string copy(first, last);
+                return std::strtod(copy.c_str(), nullptr);
+            }
+        }
+
+        const char *parseNumber(const char *first, const char *last, Number &number)
+        {
+            const char *p = first;
+            bool negative = false;
+            if (p != last && *p == '-')
+            {
+                negative = true;
+                p++;
+            }
+
+            // 整数部分，0 之后不能再跟数字
+            if (p == last || !isDigit(*p))
+            {
+                return nullptr;
+            }
+            uint64_t mantissa = 0;
+            bool overflow = false;
+            if (*p == '0')
+            {
+                p++;
+            }
+            else
+            {
+                for (; p != last && isDigit(*p); p++)
+                {
+                    uint64_t digit = uint64_t(*p - '0');
+                    if (mantissa > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+                    {
+                        overflow = true;
+                    }
+                    else
+                    {
+                        mantissa = mantissa * 10 + digit;
+                    }
+                }
+            }
+
+            bool integer = true;
+
+            // 小数部分
+            if (p != last && *p == '.')
+            {
+                p++;
+                if (p == last || !isDigit(*p))
+                {
+                    return nullptr;
+                }
+                while (p != last && isDigit(*p))
+                {
+                    p++;
+                }
+                integer = false;
+            }
+
+            // 指数部分
+            if (p != last && (*p == 'e' || *p == 'E'))
+            {
+                p++;
+                if (p != last && (*p == '+' || *p == '-'))
+                {
+                    p++;
+                }
+                if (p == last || !isDigit(*p))
+                {
+                    return nullptr;
+                }
+                while (p != last && isDigit(*p))
+                {
+                    p++;
+                }
+                integer = false;
+            }
+
+            if (integer && !overflow)
+            {
+                constexpr uint64_t int64_limit = uint64_t(std::numeric_limits<int64_t>::max());
+                if (!negative)
+                {
+                    if (mantissa <= int64_limit)
+                    {
+                        number.type = NumberType::INT64;
+                        number.int64 = int64_t(mantissa);
+                    }
+                    else
+                    {
+                        number.type = NumberType::UINT64;
+                        number.uint64 = mantissa;
+                    }
+                    return p;
+                }
+                // -0 没有对应的整数，按 double 保存以保留符号
+                if (mantissa != 0 && mantissa <= int64_limit + 1)
+                {
+                    number.type = NumberType::INT64;
+                    number.int64 = mantissa == int64_limit + 1 ? std::numeric_limits<int64_t>::min() : -int64_t(mantissa);
+                    return p;
+                }
+            }
+
+            number.type = NumberType::DOUBLE;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            // 标准库的 from_chars 使用 Eisel-Lemire 等快速算法，结果精确且不分配内存
+            auto result = std::from_chars(first, p, number.float64);
+            if (result.ec != std::errc())
+            {
+                number.float64 = slowParseDouble(first, p);
+            }
+#else
+            // 数字通常很短，拷贝到栈上再交给 strtod
+            char buffer[64];
+            if (size_t(p - first) < sizeof(buffer))
+            {
+                std::memcpy(buffer, first, p - first);
+                buffer[p - first] = '\0';
+                number.float64 = std::strtod(buffer, nullptr);
+            }
+            else
+            {
+                number.float64 = slowParseDouble(first, p);
+            }
+#endif
+            return p;
+        }
+
+        char *formatDouble(char *first, char *last, double value)
+        {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            return std::to_chars(first, last, value).ptr;
+#else
+            int n = std::snprintf(first, last - first, "%.17g", value);
+            return first + n;
+#endif
+        }
+    }
+}
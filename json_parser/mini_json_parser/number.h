@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 数字的具体类型，整数保持精确，其余使用 double
+        enum class NumberType
+        {
+            INT64,
+            UINT64,
+            DOUBLE
+        };
+
+        struct Number
+        {
+            NumberType type = NumberType::INT64;
+            union
+            {
+                int64_t int64;
+                uint64_t uint64;
+                double float64;
+            };
+
+            Number() : int64(0) {}
+
+            // 转为 double，可能丢失精度
+            double toDouble() const
+            {
+                switch (this->type)
+                {
+                case NumberType::INT64:
+                    return double(this->int64);
+                case NumberType::UINT64:
+                    return double(this->uint64);
+                default:
+                    return this->float64;
+                }
+            }
+        };
+
+        // 按 JSON 语法解析 [first, last) 开头的数字，不分配内存
+        // 没有小数点和指数且能放进 int64/uint64 的保存为整数（-0 除外），其余转为 double
+        // 返回数字的结束位置，格式错误返回 nullptr
+        const char *parseNumber(const char *first, const char *last, Number &number);
+
+        // 将 double 以能精确还原的最短形式写入 [first, last)，返回写入的结束位置
+        // 缓冲区至少需要 32 字节
+        char *formatDouble(char *first, char *last, double value);
+    }
+}
@@ -1,157 +1,87 @@
 #include "parser.h"
-#include "error.h"
+#include "treeBuilder.h"
 
 namespace civitasv
 {
     namespace json
     {
-        using Type = JsonElement::Type;
-
         // parse scaner to JsonElement
         JsonElement *Parser::parse()
         {
-            // 返回的 JsonElement
-            JsonElement *element = new JsonElement();
-            // token 类型
-            JsonTokenType token_type_ = this->scanner_.scan();
-
-            if (token_type_ != JsonTokenType::END_OF_SOURCE)
+            JsonElement *root;
+            ParseError error = this->build(nullptr, root);
+            if (error)
             {
-                // 判断并解析对应的 token
-                switch (token_type_)
-                {
-                case JsonTokenType::BEGAIN_OBJECT:
-                {
-                    JsonObject *object = this->parseObject();
-                    element->value(object);
-                    break;
-                }
-                case JsonTokenType::BEGAIN_ARRAY:
-                {
-                    JsonArray *array = this->parseArray();
-                    element->value(array);
-                    break;
-                }
-                case JsonTokenType::VALUE_STRING:
-                {
-                    std::string *val = new std::string(this->scanner_.getStringValue());
-                    element->value(val);
-                    break;
-                }
-                case JsonTokenType::VALUE_NUMBER:
-                {
-                    float number = this->scanner_.getNumberValue();
-                    element->value(number);
-                    break;
-                }
-                case JsonTokenType::LITERAL_TRUE:
-                {
-                    element->value(true);
-                    break;
-                }
-                case JsonTokenType::LITERAL_FALSE:
-                {
-
-                    element->value(false);
-                    break;
-                }
-                case JsonTokenType::LITERAL_NULL:
-                {
-                    break;
-                }
-                default:
-                {
-                    break;
-                }
-                }
+                throw ParseException(error);
             }
-
-            return element;
+            return root;
         }
 
-        // 返回 JsonObject
-        JsonObject *Parser::parseObject()
+        // 解析到 document 中
+        void Parser::parse(Document &document)
         {
-            JsonObject *res = new JsonObject();
-
-            // 判断下一个 token 是不是对象结束标志
-            JsonTokenType next = this->scanner_.scan();
-            if (next == JsonTokenType::END_OBJECT)
+            ParseError error = this->tryParse(document);
+            if (error)
             {
-                return res;
+                throw ParseException(error);
             }
-            // 回滚到上一个 token 位置
-            this->scanner_.rollback();
-
-            while (true)
-            {
-                next = this->scanner_.scan();
-                // 判断当前是否为字符串或者字典的键
-                if (next != JsonTokenType::VALUE_STRING)
-                {
-                    error("Key must be string!");
-                }
-                std::string key = this->scanner_.getStringValue();
-
-                next = this->scanner_.scan();
-                // 判断当前是否是 :
-                if (next != JsonTokenType::NMAE_SEPARATOR)
-                {
-                    error("Expected ':' in object!");
-                }
+        }
 
-                // 解析值的类型
-                (*res)[key] = this->parse();
+        // 以 SAX 的方式解析
+        bool Parser::parse(JsonHandler &handler)
+        {
+            return this->reader_.parse(this->scanner_, handler);
+        }
 
-                next = this->scanner_.scan();
-                // 判断是否到达字典结尾
-                if (next == JsonTokenType::END_OBJECT)
-                {
-                    break;
-                }
-                // 没有到达字典结尾，判断当前是否是 ,
-                if (next != JsonTokenType::VALUE_SEPARATOR)
+        // 不抛出异常地解析到 document 中
+        ParseError Parser::tryParse(Document &document)
+        {
+            document.clear();
+            try
+            {
+                JsonElement *root;
+                ParseError error = this->build(document.resource(), root);
+                if (error)
                 {
-                    error("Expected ',' in object!");
+                    // 解析失败时已分配的节点随 arena 一起丢弃
+                    document.clear();
+                    return error;
                 }
+                document.root(root);
+                return error;
+            }
+            catch (...)
+            {
+                document.clear();
+                throw;
             }
-
-            return res;
         }
 
-        // 返回 JsonArray
-        JsonArray *Parser::parseArray()
+        // 不抛出异常地以 SAX 的方式解析
+        ParseError Parser::tryParse(JsonHandler &handler)
         {
-            JsonArray *res = new JsonArray();
+            return this->reader_.tryParse(this->scanner_, handler);
+        }
 
-            // 判断下一个 token 是不是数组结束标志
-            JsonTokenType next = this->scanner_.scan();
-            if (next == JsonTokenType::END_ARRAY)
+        // 由 Reader 驱动 TreeBuilder 构建 DOM
+        ParseError Parser::build(std::pmr::memory_resource *resource, JsonElement *&root)
+        {
+            // 解析失败时 builder 析构会释放构建到一半的树
+            TreeBuilder builder(resource);
+            root = nullptr;
+            ParseError error = this->reader_.tryParse(this->scanner_, builder);
+            if (error)
             {
-                return res;
+                return error;
             }
-            // 回滚
-            this->scanner_.rollback();
 
-            while (true)
+            // 空输入解析为 null
+            if (this->reader_.empty())
             {
-                res->push_back(this->parse());
-                next = this->scanner_.scan();
-
-                // 判断是否到达数组结尾
-                if (next == JsonTokenType::END_ARRAY)
-                {
-                    break;
-                }
-
-                // 没有到达数组结尾，判断当前是否为 ,
-                if (next != JsonTokenType::VALUE_SEPARATOR)
-                {
-                    error("Expected ',' in array!");
-                }
+                builder.onNull();
             }
-
-            return res;
+            root = builder.release();
+            return error;
         }
     }
 }
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "scanner.h"
+#include "reader.h"
+#include "handler.h"
 #include "jsonElement.h"
+#include "document.h"
 
 namespace civitasv
 {
@@ -9,24 +12,44 @@ namespace civitasv
     {
         class Parser
         {
-            using JsonTokenType = Scanner::JsonTokenType;
-
         public:
-            Parser(Scanner scanner) : scanner_(scanner) {}
+            // 默认的最大嵌套深度
+            static constexpr size_t DEFAULT_MAX_DEPTH = Reader::DEFAULT_MAX_DEPTH;
+
+            Parser(Scanner scanner, size_t max_depth = DEFAULT_MAX_DEPTH)
+                : scanner_(std::move(scanner)), reader_(max_depth) {}
+
+            // 最大嵌套深度，超过时报错
+            size_t maxDepth() { return this->reader_.maxDepth(); }
+
+            void maxDepth(size_t depth) { this->reader_.maxDepth(depth); }
 
             // parse scaner to JsonElement
+            // 以下 parse() 在输入有误时抛出 ParseException，其中带有错误的位置
             JsonElement *parse();
 
-        private:
-            // 返回 JsonObject
-            JsonObject *parseObject();
+            // 解析到 document 中，所有内存都分配在 document 的 arena 上
+            void parse(Document &document);
 
-            // 返回 JsonArray
-            JsonArray *parseArray();
+            // 以 SAX 的方式解析，只回调 handler，不构建 DOM
+            // 返回 false 表示 handler 中途要求停止
+            bool parse(JsonHandler &handler);
+
+            // 不抛出异常的版本，返回错误类别、字节偏移、行号与列号，没有错误时返回的 ParseError 为空
+            // 出错时 document 被清空
+            ParseError tryParse(Document &document);
+
+            ParseError tryParse(JsonHandler &handler);
+
+        private:
+            // 由 Reader 驱动 TreeBuilder 构建 DOM，出错时 root 为 nullptr
+            ParseError build(std::pmr::memory_resource *resource, JsonElement *&root);
 
         private:
             // 使用 scanner_ 接收一个字符串或者文件
             Scanner scanner_;
+            // 语法分析的状态机
+            Reader reader_;
         };
     }
 }
@@ -0,0 +1,496 @@
+#include <charconv>
+#include "query.h"
+#include "treeBuilder.h"
+#include "error.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        using Type = JsonElement::Type;
+
+        // 非负整数下标，不允许前导 0，不是下标时返回 NO_INDEX
+        static size_t parseIndex(std::string_view token)
+        {
+            if (token.empty() || (token.size() > 1 && token[0] == '0'))
+            {
+                return JsonPath::NO_INDEX;
+            }
+            size_t index = 0;
+            auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), index);
+            if (ec != std::errc() || ptr != token.data() + token.size())
+            {
+                return JsonPath::NO_INDEX;
+            }
+            return index;
+        }
+
+        JsonPath JsonPath::fromPointer(std::string_view pointer)
+        {
+            JsonPath path;
+            if (pointer.empty())
+            {
+                return path;
+            }
+            if (pointer[0] != '/')
+            {
+                error("Invalid JSON Pointer: must start with '/'!");
+            }
+
+            size_t pos = 1;
+            while (true)
+            {
+                size_t next = pointer.find('/', pos);
+                if (next == std::string_view::npos)
+                {
+                    next = pointer.size();
+                }
+
+                // 还原 ~0 与 ~1
+                Step step;
+                step.has_key = true;
+                std::string_view token = pointer.substr(pos, next - pos);
+                for (size_t i = 0; i < token.size(); i++)
+                {
+                    if (token[i] != '~')
+                    {
+                        step.key.push_back(token[i]);
+                    }
+                    else if (i + 1 < token.size() && (token[i + 1] == '0' || token[i + 1] == '1'))
+                    {
+                        step.key.push_back(token[++i] == '0' ? '~' : '/');
+                    }
+                    else
+                    {
+                        error("Invalid JSON Pointer: bad escape!");
+                    }
+                }
+                step.index = parseIndex(step.key);
+                path.steps_.push_back(std::move(step));
+
+                if (next == pointer.size())
+                {
+                    break;
+                }
+                pos = next + 1;
+            }
+            return path;
+        }
+
+        JsonPath JsonPath::fromPath(std::string_view path)
+        {
+            if (path.empty() || path[0] != '$')
+            {
+                error("Invalid JSONPath: must start with '$'!");
+            }
+
+            JsonPath result;
+            size_t i = 1;
+            while (i < path.size())
+            {
+                Step step;
+                if (path[i] == '.')
+                {
+                    i++;
+                    if (i < path.size() && path[i] == '*')
+                    {
+                        step.wildcard = true;
+                        i++;
+                    }
+                    else
+                    {
+                        size_t start = i;
+                        while (i < path.size() && path[i] != '.' && path[i] != '[')
+                        {
+                            i++;
+                        }
+                        if (i == start)
+                        {
+                            error("Invalid JSONPath: empty key!");
+                        }
+                        step.has_key = true;
+                        step.key = path.substr(start, i - start);
+                    }
+                }
+                else if (path[i] == '[')
+                {
+                    i++;
+                    if (i < path.size() && (path[i] == '\'' || path[i] == '"'))
+                    {
+                        // ['key'] 或 ["key"]，key 中可以包含 . 与 [
+                        size_t close = path.find(path[i], i + 1);
+                        if (close == std::string_view::npos)
+                        {
+                            error("Invalid JSONPath: unterminated key!");
+                        }
+                        step.has_key = true;
+                        step.key = path.substr(i + 1, close - i - 1);
+                        i = close + 1;
+                    }
+                    else if (i < path.size() && path[i] == '*')
+                    {
+                        step.wildcard = true;
+                        i++;
+                    }
+                    else
+                    {
+                        size_t start = i;
+                        while (i < path.size() && path[i] >= '0' && path[i] <= '9')
+                        {
+                            i++;
+                        }
+                        step.index = parseIndex(path.substr(start, i - start));
+                        if (step.index == NO_INDEX)
+                        {
+                            error("Invalid JSONPath: bad index!");
+                        }
+                    }
+                    if (i >= path.size() || path[i] != ']')
+                    {
+                        error("Invalid JSONPath: expected ']'!");
+                    }
+                    i++;
+                }
+                else
+                {
+                    error("Invalid JSONPath: unexpected character!");
+                }
+                result.steps_.push_back(std::move(step));
+            }
+            return result;
+        }
+
+        bool JsonPath::wildcard() const
+        {
+            for (auto &step : this->steps_)
+            {
+                if (step.wildcard)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 以 SAX 事件输出每个匹配的值
+        bool Query::select(Scanner &scanner, JsonHandler &handler)
+        {
+            return this->run(scanner, handler, NO_LIMIT);
+        }
+
+        // 构建每个匹配的值
+        std::vector<JsonElement *> Query::select(Scanner &scanner, std::pmr::memory_resource *resource)
+        {
+            return this->collect(scanner, resource, NO_LIMIT);
+        }
+
+        // 第一个匹配的值
+        JsonElement *Query::first(Scanner &scanner, std::pmr::memory_resource *resource)
+        {
+            std::vector<JsonElement *> results = this->collect(scanner, resource, 1);
+            return results.empty() ? nullptr : results[0];
+        }
+
+        // 开始一次查询
+        bool Query::run(Scanner &scanner, JsonHandler &handler, size_t limit)
+        {
+            this->handler_ = &handler;
+            // 不含通配符时最多只有一个匹配
+            this->limit_ = this->path_.wildcard() ? limit : 1;
+            this->matched_ = 0;
+            this->stopped_ = false;
+
+            JsonTokenType token = scanner.scan();
+            if (token != JsonTokenType::END_OF_SOURCE)
+            {
+                this->match(scanner, token, 0);
+            }
+            this->handler_ = nullptr;
+            return !this->stopped_;
+        }
+
+        // 构建匹配的值
+        std::vector<JsonElement *> Query::collect(Scanner &scanner, std::pmr::memory_resource *resource, size_t limit)
+        {
+            std::vector<JsonElement *> results;
+            TreeBuilder builder(resource);
+            this->builder_ = &builder;
+            this->results_ = &results;
+            try
+            {
+                this->run(scanner, builder, limit);
+            }
+            catch (...)
+            {
+                // 已经构建好的值随查询失败一起释放，arena 上的由其所有者释放
+                if (resource == nullptr)
+                {
+                    for (auto element : results)
+                    {
+                        delete element;
+                    }
+                }
+                this->builder_ = nullptr;
+                this->results_ = nullptr;
+                throw;
+            }
+            this->builder_ = nullptr;
+            this->results_ = nullptr;
+            return results;
+        }
+
+        // 从第 step 步开始匹配以 token 开头的值
+        bool Query::match(Scanner &scanner, JsonTokenType token, size_t step)
+        {
+            if (step == this->path_.steps().size())
+            {
+                return this->emit(scanner, token);
+            }
+
+            switch (token)
+            {
+            case JsonTokenType::BEGAIN_OBJECT:
+            {
+                return this->matchObject(scanner, step);
+            }
+            case JsonTokenType::BEGAIN_ARRAY:
+            {
+                return this->matchArray(scanner, step);
+            }
+            default:
+            {
+                // 标量之下没有可以匹配的成员
+                this->skipValue(scanner, token);
+                return true;
+            }
+            }
+        }
+
+        // 在对象中匹配第 step 步
+        bool Query::matchObject(Scanner &scanner, size_t step)
+        {
+            const JsonPath::Step &current = this->path_.steps()[step];
+            if (!current.wildcard && !current.has_key)
+            {
+                scanner.skip();
+                return true;
+            }
+
+            JsonTokenType token = next(scanner);
+            if (token == JsonTokenType::END_OBJECT)
+            {
+                return true;
+            }
+            while (true)
+            {
+                if (token != JsonTokenType::VALUE_STRING)
+                {
+                    error("Key must be string!");
+                }
+                // 在下一次 scan() 之前比较，之后 key 就失效了
+                bool hit = current.wildcard || scanner.getStringView() == current.key;
+                if (next(scanner) != JsonTokenType::NMAE_SEPARATOR)
+                {
+                    error("Expected ':' in object!");
+                }
+
+                token = next(scanner);
+                if (hit)
+                {
+                    if (!this->match(scanner, token, step + 1))
+                    {
+                        return false;
+                    }
+                    // 只匹配第一个同名成员，对象剩余的部分直接跳过
+                    if (!current.wildcard)
+                    {
+                        scanner.skip();
+                        return true;
+                    }
+                }
+                else
+                {
+                    this->skipValue(scanner, token);
+                }
+
+                token = next(scanner);
+                if (token == JsonTokenType::END_OBJECT)
+                {
+                    return true;
+                }
+                if (token != JsonTokenType::VALUE_SEPARATOR)
+                {
+                    error("Expected ',' in object!");
+                }
+                token = next(scanner);
+            }
+        }
+
+        // 在数组中匹配第 step 步
+        bool Query::matchArray(Scanner &scanner, size_t step)
+        {
+            const JsonPath::Step &current = this->path_.steps()[step];
+            if (!current.wildcard && current.index == JsonPath::NO_INDEX)
+            {
+                scanner.skip();
+                return true;
+            }
+
+            JsonTokenType token = next(scanner);
+            if (token == JsonTokenType::END_ARRAY)
+            {
+                return true;
+            }
+            for (size_t i = 0;; i++)
+            {
+                if (current.wildcard || i == current.index)
+                {
+                    if (!this->match(scanner, token, step + 1))
+                    {
+                        return false;
+                    }
+                    // 下标之后的元素直接跳过
+                    if (!current.wildcard)
+                    {
+                        scanner.skip();
+                        return true;
+                    }
+                }
+                else
+                {
+                    this->skipValue(scanner, token);
+                }
+
+                token = next(scanner);
+                if (token == JsonTokenType::END_ARRAY)
+                {
+                    return true;
+                }
+                if (token != JsonTokenType::VALUE_SEPARATOR)
+                {
+                    error("Expected ',' in array!");
+                }
+                token = next(scanner);
+            }
+        }
+
+        // 完整解析以 token 开头的值
+        bool Query::emit(Scanner &scanner, JsonTokenType token)
+        {
+            this->reader_.reset();
+            bool proceed = this->reader_.consume(token, scanner, *this->handler_);
+            while (proceed && !this->reader_.complete())
+            {
+                proceed = this->reader_.consume(next(scanner), scanner, *this->handler_);
+            }
+            if (!proceed)
+            {
+                this->stopped_ = true;
+                return false;
+            }
+
+            if (this->builder_ != nullptr)
+            {
+                this->results_->push_back(this->builder_->release());
+            }
+            return ++this->matched_ < this->limit_;
+        }
+
+        // 跳过以 token 开头的值
+        void Query::skipValue(Scanner &scanner, JsonTokenType token)
+        {
+            switch (token)
+            {
+            case JsonTokenType::BEGAIN_OBJECT:
+            case JsonTokenType::BEGAIN_ARRAY:
+            {
+                scanner.skip();
+                break;
+            }
+            case JsonTokenType::VALUE_STRING:
+            case JsonTokenType::VALUE_NUMBER:
+            case JsonTokenType::LITERAL_TRUE:
+            case JsonTokenType::LITERAL_FALSE:
+            case JsonTokenType::LITERAL_NULL:
+            {
+                break;
+            }
+            default:
+            {
+                error("Unexpected token in value!");
+                break;
+            }
+            }
+        }
+
+        // 读取下一个 token，提前结束时报错
+        Scanner::JsonTokenType Query::next(Scanner &scanner)
+        {
+            JsonTokenType token = scanner.scan();
+            if (token == JsonTokenType::END_OF_SOURCE)
+            {
+                error("Unexpected end of source!");
+            }
+            return token;
+        }
+
+        // 在已经解析好的树上查询，逐步展开匹配的节点
+        std::vector<JsonElement *> select(JsonElement *root, const JsonPath &path)
+        {
+            std::vector<JsonElement *> current;
+            if (root != nullptr)
+            {
+                current.push_back(root);
+            }
+
+            std::vector<JsonElement *> matched;
+            for (auto &step : path.steps())
+            {
+                matched.clear();
+                for (auto element : current)
+                {
+                    if (element->type() == Type::JSON_OBJECT)
+                    {
+                        JsonObject *object = element->asObject();
+                        if (step.wildcard)
+                        {
+                            for (auto &[key, value] : *object)
+                            {
+                                matched.push_back(value);
+                            }
+                        }
+                        else if (step.has_key)
+                        {
+                            auto iter = object->find(step.key);
+                            if (iter != object->end())
+                            {
+                                matched.push_back(iter->second);
+                            }
+                        }
+                    }
+                    else if (element->type() == Type::JSON_ARRAY)
+                    {
+                        JsonArray *array = element->asArray();
+                        if (step.wildcard)
+                        {
+                            matched.insert(matched.end(), array->begin(), array->end());
+                        }
+                        else if (step.index < array->size())
+                        {
+                            matched.push_back((*array)[step.index]);
+                        }
+                    }
+                }
+                current.swap(matched);
+            }
+            return current;
+        }
+
+        // 按 JSON Pointer 查找
+        JsonElement *find(JsonElement *root, std::string_view pointer)
+        {
+            std::vector<JsonElement *> matched = select(root, JsonPath::fromPointer(pointer));
+            return matched.empty() ? nullptr : matched[0];
+        }
+    }
+}
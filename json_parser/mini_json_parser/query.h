@@ -0,0 +1,123 @@
+#pragma once
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "handler.h"
+#include "jsonElement.h"
+#include "reader.h"
+#include "scanner.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        class TreeBuilder;
+
+        // 解析后的查询路径，由 JSON Pointer（RFC 6901）或简单的 JSONPath 得到
+        // JSONPath 支持 $、.key、['key']、[index]、.* 与 [*]
+        class JsonPath
+        {
+        public:
+            static constexpr size_t NO_INDEX = size_t(-1);
+
+            // 路径中的一步
+            struct Step
+            {
+                // 匹配对象中 key 相同的成员
+                bool has_key = false;
+                std::string key;
+                // 匹配数组中的第 index 个元素，NO_INDEX 表示不匹配数组
+                size_t index = NO_INDEX;
+                // 匹配对象或数组中的所有成员
+                bool wildcard = false;
+            };
+
+            // "/glossary/hello2"，空串表示整个文档，~1 表示 /，~0 表示 ~
+            // 由数字组成的一段既可以匹配对象的 key，也可以匹配数组下标
+            static JsonPath fromPointer(std::string_view pointer);
+
+            // "$.glossary.hello2"、"$.list[0]"、"$['a.b'][*]"
+            static JsonPath fromPath(std::string_view path);
+
+            const std::vector<Step> &steps() const { return this->steps_; }
+
+            // 是否包含通配符，不含时最多只有一个匹配
+            bool wildcard() const;
+
+        private:
+            std::vector<Step> steps_;
+        };
+
+        // 在 Scanner 上直接查询，不构建整棵树
+        // 与路径无关的子树只做括号配对后跳过，不解析也不校验其中的内容，只有匹配的值才会被完整解析
+        // 路径不含通配符时找到第一个匹配就停止扫描，重复的 key 以第一次出现的为准
+        class Query
+        {
+            using JsonTokenType = Scanner::JsonTokenType;
+
+        public:
+            explicit Query(JsonPath path, size_t max_depth = Reader::DEFAULT_MAX_DEPTH)
+                : path_(std::move(path)), reader_(max_depth) {}
+
+            // 依次以 SAX 事件输出每个匹配的值
+            // 返回 false 表示 handler 中途要求停止
+            bool select(Scanner &scanner, JsonHandler &handler);
+
+            // 构建每个匹配的值，resource 为空时逐个 new，由调用方释放
+            std::vector<JsonElement *> select(Scanner &scanner, std::pmr::memory_resource *resource = nullptr);
+
+            // 第一个匹配的值，没有匹配时返回 nullptr
+            JsonElement *first(Scanner &scanner, std::pmr::memory_resource *resource = nullptr);
+
+        private:
+            static constexpr size_t NO_LIMIT = size_t(-1);
+
+            // 开始一次查询，最多匹配 limit 个值
+            bool run(Scanner &scanner, JsonHandler &handler, size_t limit);
+
+            // 构建最多 limit 个匹配的值
+            std::vector<JsonElement *> collect(Scanner &scanner, std::pmr::memory_resource *resource, size_t limit);
+
+            // 从第 step 步开始匹配以 token 开头的值
+            // 返回 false 表示停止扫描
+            bool match(Scanner &scanner, JsonTokenType token, size_t step);
+
+            // 在对象中匹配第 step 步
+            bool matchObject(Scanner &scanner, size_t step);
+
+            // 在数组中匹配第 step 步
+            bool matchArray(Scanner &scanner, size_t step);
+
+            // 完整解析以 token 开头的值，交给 handler_
+            bool emit(Scanner &scanner, JsonTokenType token);
+
+            // 跳过以 token 开头的值
+            void skipValue(Scanner &scanner, JsonTokenType token);
+
+            // 读取下一个 token，提前结束时报错
+            static JsonTokenType next(Scanner &scanner);
+
+        private:
+            JsonPath path_;
+            // 解析匹配的值
+            Reader reader_;
+            JsonHandler *handler_ = nullptr;
+            // 构建匹配值时使用，其余时候为空
+            TreeBuilder *builder_ = nullptr;
+            std::vector<JsonElement *> *results_ = nullptr;
+            // 最多匹配的数量与已经匹配的数量
+            size_t limit_ = 0;
+            size_t matched_ = 0;
+            // handler 要求停止
+            bool stopped_ = false;
+        };
+
+        // 在已经解析好的树上查询，返回的节点仍属于 root
+        std::vector<JsonElement *> select(JsonElement *root, const JsonPath &path);
+
+        // 按 JSON Pointer 查找，不存在时返回 nullptr
+        JsonElement *find(JsonElement *root, std::string_view pointer);
+    }
+}
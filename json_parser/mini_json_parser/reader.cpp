@@ -0,0 +1,250 @@
+#include "reader.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 从 scanner 中读取一个完整的值
+        bool Reader::parse(Scanner &scanner, JsonHandler &handler)
+        {
+            if (this->run(scanner, handler))
+            {
+                return true;
+            }
+            if (this->error_)
+            {
+                throw ParseException(this->error_);
+            }
+            return false;
+        }
+
+        // 不抛出异常的 parse()
+        ParseError Reader::tryParse(Scanner &scanner, JsonHandler &handler)
+        {
+            this->run(scanner, handler);
+            return this->error_;
+        }
+
+        // 读取一个完整的值
+        bool Reader::run(Scanner &scanner, JsonHandler &handler)
+        {
+            this->reset();
+
+            while (!this->complete())
+            {
+                JsonTokenType token = scanner.tryScan();
+                if (token == JsonTokenType::INVALID_INPUT)
+                {
+                    this->error_ = scanner.lastError();
+                    return false;
+                }
+                if (token == JsonTokenType::END_OF_SOURCE)
+                {
+                    // 空输入不产生事件
+                    if (this->empty())
+                    {
+                        return true;
+                    }
+                    return this->fail(scanner, ErrorCode::UNEXPECTED_END, "Unexpected end of source!");
+                }
+
+                if (!this->step(token, scanner, handler))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // 推入一个 token
+        bool Reader::consume(JsonTokenType token, Scanner &scanner, JsonHandler &handler)
+        {
+            this->error_ = ParseError();
+            if (this->step(token, scanner, handler))
+            {
+                return true;
+            }
+            if (this->error_)
+            {
+                throw ParseException(this->error_);
+            }
+            return false;
+        }
+
+        // 不抛出异常的 consume()
+        bool Reader::step(JsonTokenType token, Scanner &scanner, JsonHandler &handler)
+        {
+            switch (this->state_)
+            {
+            case State::VALUE_OR_END:
+            {
+                if (token == JsonTokenType::END_ARRAY)
+                {
+                    this->pop();
+                    return handler.onEndArray();
+                }
+                return this->value(token, scanner, handler);
+            }
+            case State::VALUE:
+            {
+                return this->value(token, scanner, handler);
+            }
+            case State::KEY_OR_END:
+            {
+                if (token == JsonTokenType::END_OBJECT)
+                {
+                    this->pop();
+                    return handler.onEndObject();
+                }
+                [[fallthrough]];
+            }
+            case State::KEY:
+            {
+                // 判断当前是否为字符串或者字典的键
+                if (token != JsonTokenType::VALUE_STRING)
+                {
+                    return this->fail(scanner, ErrorCode::UNEXPECTED_TOKEN, "Key must be string!");
+                }
+                this->state_ = State::NAME_SEPARATOR;
+                return handler.onKey(scanner.getStringView());
+            }
+            case State::NAME_SEPARATOR:
+            {
+                // 判断当前是否是 :
+                if (token != JsonTokenType::NMAE_SEPARATOR)
+                {
+                    return this->fail(scanner, ErrorCode::UNEXPECTED_TOKEN, "Expected ':' in object!");
+                }
+                this->state_ = State::VALUE;
+                return true;
+            }
+            case State::SEPARATOR_OR_END:
+            {
+                if (this->stack_.back() == Container::OBJECT)
+                {
+                    // 判断是否到达字典结尾
+                    if (token == JsonTokenType::END_OBJECT)
+                    {
+                        this->pop();
+                        return handler.onEndObject();
+                    }
+                    // 没有到达字典结尾，判断当前是否是 ,
+                    if (token != JsonTokenType::VALUE_SEPARATOR)
+                    {
+                        return this->fail(scanner, ErrorCode::UNEXPECTED_TOKEN, "Expected ',' in object!");
+                    }
+                    this->state_ = State::KEY;
+                }
+                else
+                {
+                    // 判断是否到达数组结尾
+                    if (token == JsonTokenType::END_ARRAY)
+                    {
+                        this->pop();
+                        return handler.onEndArray();
+                    }
+                    // 没有到达数组结尾，判断当前是否为 ,
+                    if (token != JsonTokenType::VALUE_SEPARATOR)
+                    {
+                        return this->fail(scanner, ErrorCode::UNEXPECTED_TOKEN, "Expected ',' in array!");
+                    }
+                    this->state_ = State::VALUE;
+                }
+                return true;
+            }
+            default:
+            {
+                return this->fail(scanner, ErrorCode::UNEXPECTED_TOKEN, "Unexpected token after end of value!");
+            }
+            }
+        }
+
+        // 处理一个值
+        bool Reader::value(JsonTokenType token, Scanner &scanner, JsonHandler &handler)
+        {
+            // 判断并解析对应的 token
+            switch (token)
+            {
+            case JsonTokenType::BEGAIN_OBJECT:
+            {
+                if (!this->push(Container::OBJECT, scanner))
+                {
+                    return false;
+                }
+                this->state_ = State::KEY_OR_END;
+                return handler.onStartObject();
+            }
+            case JsonTokenType::BEGAIN_ARRAY:
+            {
+                if (!this->push(Container::ARRAY, scanner))
+                {
+                    return false;
+                }
+                this->state_ = State::VALUE_OR_END;
+                return handler.onStartArray();
+            }
+            case JsonTokenType::VALUE_STRING:
+            {
+                this->endValue();
+                return handler.onString(scanner.getStringView());
+            }
+            case JsonTokenType::VALUE_NUMBER:
+            {
+                this->endValue();
+                return handler.onNumber(scanner.getNumber());
+            }
+            case JsonTokenType::LITERAL_TRUE:
+            {
+                this->endValue();
+                return handler.onBool(true);
+            }
+            case JsonTokenType::LITERAL_FALSE:
+            {
+                this->endValue();
+                return handler.onBool(false);
+            }
+            case JsonTokenType::LITERAL_NULL:
+            {
+                this->endValue();
+                return handler.onNull();
+            }
+            default:
+            {
+                return this->fail(scanner, ErrorCode::UNEXPECTED_TOKEN, "Unexpected token in value!");
+            }
+            }
+        }
+
+        // 记录位于当前 token 处的错误
+        bool Reader::fail(Scanner &scanner, ErrorCode code, const char *message)
+        {
+            this->error_ = scanner.makeError(code, message, scanner.tokenPosition());
+            return false;
+        }
+
+        // 压入一层容器
+        bool Reader::push(Container container, Scanner &scanner)
+        {
+            if (this->stack_.size() >= this->max_depth_)
+            {
+                return this->fail(scanner, ErrorCode::DEPTH_EXCEEDED, "Exceeded max nesting depth!");
+            }
+            this->stack_.push_back(container);
+            return true;
+        }
+
+        // 弹出一层容器
+        void Reader::pop()
+        {
+            this->stack_.pop_back();
+            this->endValue();
+        }
+
+        // 一个值结束后的状态
+        void Reader::endValue()
+        {
+            this->state_ = this->stack_.empty() ? State::DONE : State::SEPARATOR_OR_END;
+        }
+    }
+}
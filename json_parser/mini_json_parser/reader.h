@@ -0,0 +1,118 @@
+#pragma once
+
+#include <vector>
+#include "scanner.h"
+#include "handler.h"
+#include "error.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 语法分析的状态机，把 Scanner 产生的 token 转换为 JsonHandler 事件
+        // 只保存未闭合容器的显式栈，内存与文档大小无关，只与嵌套深度有关
+        // token 可以由 parse() 从 Scanner 中拉取，也可以逐个 consume() 推入
+        class Reader
+        {
+            using JsonTokenType = Scanner::JsonTokenType;
+
+        public:
+            // 默认的最大嵌套深度
+            static constexpr size_t DEFAULT_MAX_DEPTH = 1024;
+
+            explicit Reader(size_t max_depth = DEFAULT_MAX_DEPTH) : max_depth_(max_depth) {}
+
+            // 最大嵌套深度，超过时报错
+            size_t maxDepth() { return this->max_depth_; }
+
+            void maxDepth(size_t depth) { this->max_depth_ = depth; }
+
+            // 从 scanner 中读取一个完整的值，依次回调 handler
+            // 返回 false 表示 handler 中途要求停止
+            // source 为空时不产生任何事件，输入有误或值不完整时抛出 ParseException
+            bool parse(Scanner &scanner, JsonHandler &handler);
+
+            // 不抛出异常的 parse()，返回错误及其位置，没有错误时返回的 ParseError 为空
+            // handler 中途要求停止同样返回空的 ParseError，出错之前的事件已经回调过了
+            ParseError tryParse(Scanner &scanner, JsonHandler &handler);
+
+            // 推入一个 token，token 对应的值从 scanner 中读取
+            // 返回 false 表示 handler 要求停止，token 不合语法时抛出 ParseException
+            bool consume(JsonTokenType token, Scanner &scanner, JsonHandler &handler);
+
+            // 是否已经读完一个完整的值
+            bool complete() { return this->state_ == State::DONE; }
+
+            // 是否还没有读到任何 token
+            bool empty() { return this->state_ == State::VALUE && this->stack_.empty(); }
+
+            // 当前嵌套深度
+            size_t depth() { return this->stack_.size(); }
+
+            // 重置状态，准备读取下一个值
+            void reset()
+            {
+                this->state_ = State::VALUE;
+                this->stack_.clear();
+                this->error_ = ParseError();
+            }
+
+        private:
+            // 解析状态
+            enum class State
+            {
+                // 期望一个值
+                VALUE,
+                // [ 之后，期望一个值或 ]
+                VALUE_OR_END,
+                // { 之后，期望一个 key 或 }
+                KEY_OR_END,
+                // , 之后，期望一个 key
+                KEY,
+                // key 之后，期望 :
+                NAME_SEPARATOR,
+                // 值之后，期望 , 或结束符
+                SEPARATOR_OR_END,
+                // 已经读完一个完整的值
+                DONE
+            };
+
+            // 容器类型
+            enum class Container : char
+            {
+                OBJECT,
+                ARRAY
+            };
+
+            // 读取一个完整的值，返回 false 表示 handler 要求停止或出错，错误保存在 error_ 中
+            bool run(Scanner &scanner, JsonHandler &handler);
+
+            // 不抛出异常的 consume()
+            bool step(JsonTokenType token, Scanner &scanner, JsonHandler &handler);
+
+            // 处理一个值
+            bool value(JsonTokenType token, Scanner &scanner, JsonHandler &handler);
+
+            // 记录位于当前 token 处的错误，返回 false
+            bool fail(Scanner &scanner, ErrorCode code, const char *message);
+
+            // 压入一层容器，超过最大嵌套深度时返回 false
+            bool push(Container container, Scanner &scanner);
+
+            // 弹出一层容器，并切换到值之后的状态
+            void pop();
+
+            // 一个值结束后的状态
+            void endValue();
+
+        private:
+            // 最大嵌套深度
+            size_t max_depth_;
+            State state_ = State::VALUE;
+            // 显式栈，代替递归
+            std::vector<Container> stack_;
+            // 最近一次的错误
+            ParseError error_;
+        };
+    }
+}
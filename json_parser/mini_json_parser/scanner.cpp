@@ -1,4 +1,7 @@
+#include <algorithm>
 #include "scanner.h"
+#include "structuralIndex.h"
+#include "utf8.h"
 #include "error.h"
 
 namespace civitasv
@@ -11,137 +14,374 @@ namespace civitasv
             return current_ >= this->source_.size();
         }
 
+        // 记录当前 token 的错误
+        void Scanner::fail(ErrorCode code, const char *message, size_t offset)
+        {
+            this->error_ = this->makeError(code, message, offset);
+            this->failed_ = true;
+        }
+
+        // 构造位于 offset 处的错误
+        ParseError Scanner::makeError(ErrorCode code, const char *message, size_t offset)
+        {
+            offset = std::min(offset, this->source_.size());
+            std::string_view before = this->source_.substr(0, offset);
+            size_t newline = before.rfind('\n');
+
+            ParseError error;
+            error.code = code;
+            error.message = message;
+            error.offset = offset;
+            error.line = 1 + std::count(before.begin(), before.end(), '\n');
+            error.column = newline == std::string_view::npos ? offset + 1 : offset - newline;
+            return error;
+        }
+
         // 下一个字符
         char Scanner::advance()
         {
             return this->source_[this->current_++];
         }
 
-        // 扫描判断是否是 true
-        void Scanner::scanTrue()
+        // 扫描 true/false/null 首字符之后的部分
+        void Scanner::scanLiteral(std::string_view rest, const char *message)
         {
-            if (this->source_.compare(this->current_, 3, "rue") == 0)
+            // 分段模式下，source 结尾处的前缀留到下一段再判断
+            size_t available = this->source_.size() - this->current_;
+            if (this->partial_ && available < rest.size() && this->source_.substr(this->current_) == rest.substr(0, available))
+            {
+                this->incomplete_ = true;
+                return;
+            }
+
+            if (this->source_.compare(this->current_, rest.size(), rest) == 0)
             {
-                this->current_ += 3;
+                this->current_ += rest.size();
             }
             else
             {
-                error("Scan 'true' error");
+                this->fail(ErrorCode::INVALID_TOKEN, message, this->current_ - 1);
             }
         }
 
+        // 扫描判断是否是 true
+        void Scanner::scanTrue()
+        {
+            this->scanLiteral("rue", "Scan 'true' error");
+        }
+
         // 扫描判断是否是 false
         void Scanner::scanFalse()
         {
-            if (this->source_.compare(this->current_, 4, "alse") == 0)
-            {
-                this->current_ += 4;
-            }
-            else
-            {
-                error("Scan 'false' error");
-            }
+            this->scanLiteral("alse", "Scan 'false' error");
         }
 
         // 扫描判断是否是 null
         void Scanner::scanNull()
         {
-            if (this->source_.compare(this->current_, 3, "ull") == 0)
-            {
-                this->current_ += 3;
-            }
-            else
-            {
-                error("Scan 'null' error");
-            }
+            this->scanLiteral("ull", "Scan 'null' error");
         }
 
         // 扫描判断是否是 number 类型
+        // 直接在 source 上解析，不分配内存
         void Scanner::scanNumber()
         {
             // 当前位置
             size_t pos = this->current_ - 1;
+            const char *begin = this->source_.data();
 
-            // 负数
-            while (this->isDigit(this->peek()))
-            {
-                this->advance();
-            }
-
-            // 含有小数点
-            if (this->peek() == '.' && this->isDigit(this->peekNext()))
+            // 分段模式下，数字一直延续到 source 结尾时可能还没结束
+            if (this->partial_)
             {
-                // 移动，跳过小数点
-                this->advance();
-
-                // 小数点后的数字
-                while (this->isDigit(this->peek()))
+                size_t end = this->current_;
+                while (end < this->source_.size() && (this->isDigit(this->source_[end]) || this->source_[end] == '.' ||
+                                                      this->source_[end] == 'e' || this->source_[end] == 'E' ||
+                                                      this->source_[end] == '+' || this->source_[end] == '-'))
+                {
+                    end++;
+                }
+                if (end == this->source_.size())
                 {
-                    this->advance();
+                    this->incomplete_ = true;
+                    return;
                 }
             }
 
-            // 保存数字
-            this->value_number_ = std::atof(this->source_.substr(pos, this->current_ - pos).c_str());
+            const char *end = parseNumber(begin + pos, begin + this->source_.size(), this->value_number_);
+            if (end == nullptr)
+            {
+                this->fail(ErrorCode::INVALID_NUMBER, "invalid number", pos);
+                return;
+            }
+            this->current_ = end - begin;
         }
 
         // 扫描判断是否是 string 类型
         void Scanner::scanString()
         {
-            size_t pos = this->current_;
+            const char *first = this->source_.data();
+            const char *last = first + this->source_.size();
+            const char *start = first + this->current_;
+            const char *p = start;
+            // 尚未拷贝到 value_buffer_ 的一段
+            const char *run = start;
+            bool escaped = false;
 
-            // 字符串起始
-            while (this->peek() != '\"' && !this->isAtEnd())
+            // 一次遍历完成查找结束引号、解码转义字符与校验 UTF-8
+            while (true)
             {
-                this->advance();
-
-                // 转义字符
-                if (this->peek() == '\\')
+                // 不含特殊字符的一段整体跳过
+                p = findStringSpecial(p, last);
+                if (p == last || *p == '\"')
                 {
-                    // 跳过转移 `\`
-                    this->advance();
+                    break;
+                }
 
-                    // `\` 后的字符
-                    switch (this->peek())
+                unsigned char c = *p;
+                if (c == '\\')
+                {
+                    // 第一个转义字符之前的部分整段拷贝，之后都写入 value_buffer_
+                    if (!escaped)
                     {
-                    case 'b':
-                    case 't':
-                    case 'n':
-                    case 'f':
-                    case 'r':
-                    case '\"':
-                    case '\\':
+                        this->value_buffer_.clear();
+                        escaped = true;
+                    }
+                    this->value_buffer_.append(run, p - run);
+                    p = this->unescape(p, last);
+                    if (p == nullptr)
                     {
-                        this->advance();
+                        if (this->failed_)
+                        {
+                            return;
+                        }
+                        p = last;
                         break;
                     }
-                    case 'u':
+                    run = p;
+                }
+                else if (c < 0x20)
+                {
+                    this->fail(ErrorCode::INVALID_STRING, "invalid string: control character", p - first);
+                    return;
+                }
+                else
+                {
+                    // 连续的多字节字符逐个校验，不再回到 findStringSpecial
+                    bool truncated = false;
+                    while (p != last && (unsigned char)*p >= 0x80 && !truncated)
                     {
-                        // unicode 字符长度为 4
-                        for (int i = 0; i < 4; i++)
+                        const char *q = skipUtf8(p, last, truncated);
+                        if (q == nullptr)
                         {
-                            this->advance();
+                            this->fail(ErrorCode::INVALID_STRING, "invalid string: bad UTF-8", p - first);
+                            return;
                         }
-                        break;
+                        p = q;
                     }
-                    default:
+                }
+            }
+
+            // 缺少字符串结束的 "，分段模式下留到下一段
+            if (p == last && this->partial_)
+            {
+                this->incomplete_ = true;
+                return;
+            }
+            if (p == last)
+            {
+                this->fail(ErrorCode::INVALID_STRING, "invalid string: missing closing quote", start - 1 - first);
+                return;
+            }
+
+            this->current_ = p + 1 - first;
+
+            // 没有转义字符时直接指向 source，不拷贝
+            if (escaped)
+            {
+                this->value_buffer_.append(run, p - run);
+                this->value_string_ = this->value_buffer_;
+            }
+            else
+            {
+                this->value_string_ = std::string_view(start, p - start);
+            }
+        }
+
+        // 跳过当前容器的剩余部分
+        void Scanner::skip()
+        {
+            const char *first = this->source_.data();
+            const char *last = first + this->source_.size();
+            const char *p = first + this->current_;
+
+            size_t depth = 1;
+            while (p != last)
+            {
+                char c = *p++;
+                if (c == '"')
+                {
+                    // 跳过字符串，其中的括号不计数
+                    while (p != last && *p != '"')
                     {
-                        break;
+                        p += (*p == '\\' && p + 1 != last) ? 2 : 1;
                     }
+                    if (p == last)
+                    {
+                        break;
                     }
+                    p++;
+                }
+                else if (c == '{' || c == '[')
+                {
+                    depth++;
+                }
+                else if ((c == '}' || c == ']') && --depth == 0)
+                {
+                    this->seek(p - first);
+                    return;
                 }
             }
 
-            // 缺少字符串结束的 "
-            if (this->isAtEnd())
+            this->current_ = this->source_.size();
+            throw ParseException(this->makeError(ErrorCode::UNEXPECTED_END, "Unexpected end of source!", this->current_));
+        }
+
+        // 跳到 position
+        void Scanner::seek(size_t position)
+        {
+            this->current_ = position;
+            // 索引模式下同步到下一个 token
+            if (this->index_ != nullptr)
             {
-                error("invalid string: missing closing quote");
+                this->index_pos_ = std::lower_bound(this->index_->begin(), this->index_->end(), uint32_t(position)) - this->index_->begin();
             }
+        }
 
-            this->advance();
+        // 读取 p 开头的 4 位十六进制数字，返回 1 表示成功，0 表示不足 4 位，-1 表示含有非十六进制字符
+        static int readHex4(const char *p, const char *last, uint32_t &code)
+        {
+            if (last - p < 4)
+            {
+                return 0;
+            }
+            code = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                char c = p[i];
+                code <<= 4;
+                if (c >= '0' && c <= '9')
+                {
+                    code |= uint32_t(c - '0');
+                }
+                else if (c >= 'a' && c <= 'f')
+                {
+                    code |= uint32_t(c - 'a' + 10);
+                }
+                else if (c >= 'A' && c <= 'F')
+                {
+                    code |= uint32_t(c - 'A' + 10);
+                }
+                else
+                {
+                    return -1;
+                }
+            }
+            return 1;
+        }
 
-            // 保留字符串结果
-            this->value_string_ = this->source_.substr(pos, this->current_ - pos - 1);
+        // 解码 p 处的一个转义字符
+        const char *Scanner::unescape(const char *p, const char *last)
+        {
+            std::string &out = this->value_buffer_;
+            // 出错时报告转义字符的起始位置
+            size_t offset = p - this->source_.data();
+            if (last - p < 2)
+            {
+                return nullptr;
+            }
+
+            char c = p[1];
+            p += 2;
+            switch (c)
+            {
+            case '\"':
+            case '\\':
+            case '/':
+                out.push_back(c);
+                return p;
+            case 'b':
+                out.push_back('\b');
+                return p;
+            case 'f':
+                out.push_back('\f');
+                return p;
+            case 'n':
+                out.push_back('\n');
+                return p;
+            case 'r':
+                out.push_back('\r');
+                return p;
+            case 't':
+                out.push_back('\t');
+                return p;
+            case 'u':
+            {
+                uint32_t code;
+                int result = readHex4(p, last, code);
+                if (result <= 0)
+                {
+                    if (result < 0)
+                    {
+                        this->fail(ErrorCode::INVALID_STRING, "invalid string: bad unicode escape", offset);
+                    }
+                    return nullptr;
+                }
+                p += 4;
+
+                if (code >= 0xDC00 && code <= 0xDFFF)
+                {
+                    this->fail(ErrorCode::INVALID_STRING, "invalid string: lone surrogate", offset);
+                    return nullptr;
+                }
+                // 代理对，高位之后必须紧跟低位
+                if (code >= 0xD800 && code <= 0xDBFF)
+                {
+                    if ((p != last && p[0] != '\\') || (last - p >= 2 && p[1] != 'u'))
+                    {
+                        this->fail(ErrorCode::INVALID_STRING, "invalid string: lone surrogate", offset);
+                        return nullptr;
+                    }
+                    if (last - p < 2)
+                    {
+                        return nullptr;
+                    }
+                    uint32_t low;
+                    result = readHex4(p + 2, last, low);
+                    if (result <= 0)
+                    {
+                        if (result < 0)
+                        {
+                            this->fail(ErrorCode::INVALID_STRING, "invalid string: bad unicode escape", p - this->source_.data());
+                        }
+                        return nullptr;
+                    }
+                    if (low < 0xDC00 || low > 0xDFFF)
+                    {
+                        this->fail(ErrorCode::INVALID_STRING, "invalid string: lone surrogate", offset);
+                        return nullptr;
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+                appendUtf8(out, code);
+                return p;
+            }
+            default:
+            {
+                this->fail(ErrorCode::INVALID_STRING, "invalid string: bad escape", offset);
+                return nullptr;
+            }
+            }
         }
 
         // 判断是否是数字
@@ -150,6 +390,38 @@ namespace civitasv
             return c >= '0' && c <= '9';
         }
 
+        // 索引模式下检查 scalar 的结尾
+        void Scanner::checkScalarEnd()
+        {
+            if (this->isAtEnd())
+            {
+                return;
+            }
+
+            switch (this->peek())
+            {
+            case ' ':
+            case '\r':
+            case '\n':
+            case '\t':
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+            case '\"':
+            {
+                break;
+            }
+            default:
+            {
+                this->index_.reset();
+                break;
+            }
+            }
+        }
+
         // 当前字符
         char Scanner::peek()
         {
@@ -177,8 +449,36 @@ namespace civitasv
         }
 
         // 扫描字符串，返回对应的 json 内容类型
-        Scanner::JsonTokenType Scanner::scan()
+        Scanner::JsonTokenType Scanner::tryScan()
         {
+            // 记录 token 起始位置，用于回滚
+            this->prev_pos_ = this->current_;
+            this->prev_index_pos_ = this->index_pos_;
+
+            // 索引模式，直接跳到下一个 token
+            if (this->index_ != nullptr)
+            {
+                if (this->index_pos_ >= this->index_->size())
+                {
+                    this->current_ = this->source_.size();
+                    this->token_pos_ = this->current_;
+                    return JsonTokenType::END_OF_SOURCE;
+                }
+                this->current_ = (*this->index_)[this->index_pos_++];
+            }
+
+            // 跳过空白，循环代替递归
+            while (!this->isAtEnd())
+            {
+                char c = this->source_[this->current_];
+                if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+                {
+                    break;
+                }
+                this->current_++;
+            }
+            this->token_pos_ = this->current_;
+
             // 是否扫描完毕
             if (isAtEnd())
             {
@@ -186,6 +486,7 @@ namespace civitasv
             }
 
             // 获取下一个字符
+            size_t start = this->current_;
             char c = advance();
             // 判断该字符
 
@@ -218,17 +519,17 @@ namespace civitasv
             case 't':
             {
                 scanTrue();
-                return JsonTokenType::LITERAL_TRUE;
+                return this->endScalar(JsonTokenType::LITERAL_TRUE, start);
             }
             case 'f':
             {
                 scanFalse();
-                return JsonTokenType::LITERAL_FALSE;
+                return this->endScalar(JsonTokenType::LITERAL_FALSE, start);
             }
             case 'n':
             {
                 scanNull();
-                return JsonTokenType::LITERAL_NULL;
+                return this->endScalar(JsonTokenType::LITERAL_NULL, start);
             }
             case '-':
             case '0':
@@ -243,36 +544,68 @@ namespace civitasv
             case '9':
             {
                 scanNumber();
-                return JsonTokenType::VALUE_NUMBER;
+                return this->endScalar(JsonTokenType::VALUE_NUMBER, start);
             }
             case '\"':
             {
                 scanString();
-                return JsonTokenType::VALUE_STRING;
-            }
-            case ' ':
-            case '\r':
-            case '\n':
-            case '\t':
-            {
-                return scan();
+                return this->endScalar(JsonTokenType::VALUE_STRING, start);
             }
             default:
             {
-                // error
-                std::string message = "Unsupported Token: ";
-                message += c;
-                error(std::string(message));
+                this->fail(ErrorCode::INVALID_TOKEN, "Unsupported token", start);
+                return this->endScalar(JsonTokenType::INVALID_INPUT, start);
+            }
+            }
+        }
 
+        // 值类型 token 扫描结束后的处理
+        Scanner::JsonTokenType Scanner::endScalar(JsonTokenType type, size_t start)
+        {
+            if (this->failed_)
+            {
+                this->failed_ = false;
+                return JsonTokenType::INVALID_INPUT;
+            }
+            // token 不完整，回到 token 起始位置，等待更多数据
+            if (this->incomplete_)
+            {
+                this->incomplete_ = false;
+                this->current_ = start;
                 return JsonTokenType::END_OF_SOURCE;
             }
+            if (this->index_ != nullptr && type != JsonTokenType::VALUE_STRING)
+            {
+                this->checkScalarEnd();
             }
+            return type;
         }
 
         // 回滚
         void Scanner::rollback()
         {
             this->current_ = this->prev_pos_;
+            this->index_pos_ = this->prev_index_pos_;
+        }
+
+        // 构建 token 起始位置索引
+        void Scanner::buildIndex()
+        {
+            auto index = std::make_shared<std::vector<uint32_t>>();
+            if (!StructuralIndexer().index(this->source_, *index))
+            {
+                // 过大的 source 退回逐字符扫描
+                return;
+            }
+
+            // 从当前位置开始使用索引
+            this->index_pos_ = 0;
+            while (this->index_pos_ < index->size() && (*index)[this->index_pos_] < this->current_)
+            {
+                this->index_pos_++;
+            }
+            this->prev_index_pos_ = this->index_pos_;
+            this->index_ = std::move(index);
         }
     }
 }
@@ -1,7 +1,12 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
+#include "number.h"
+#include "error.h"
 
 namespace civitasv
 {
@@ -10,8 +15,16 @@ namespace civitasv
         class Scanner
         {
         public:
-            // 构造函数
-            Scanner(std::string source) : source_(source), current_(0) {}
+            // 构造函数，Scanner 持有 source 的一份拷贝
+            Scanner(std::string source)
+                : owned_(std::make_shared<const std::string>(std::move(source))),
+                  source_(*owned_) {}
+
+            Scanner(const char *source) : Scanner(std::string(source)) {}
+
+            // 借用模式，不拷贝 source，调用方需保证其在整个解析过程中有效
+            // 可以指向 std::string、mmap 映射的文件等任意连续内存
+            explicit Scanner(std::string_view source) : source_(source) {}
 
             enum class JsonTokenType
             {
@@ -43,7 +56,10 @@ namespace civitasv
                 END_ARRAY,
 
                 // EOF
-                END_OF_SOURCE
+                END_OF_SOURCE,
+
+                // tryScan() 遇到错误，详情见 lastError()
+                INVALID_INPUT
             };
 
             // 重载输出运算符
@@ -111,6 +127,11 @@ namespace civitasv
                     os << "EOF";
                     break;
                 }
+                case Scanner::JsonTokenType::INVALID_INPUT:
+                {
+                    os << "invalid";
+                    break;
+                }
                 default:
                 {
                     break;
@@ -122,38 +143,111 @@ namespace civitasv
 
             // 获取下一个 token 类型
             // 如果是 string 或 number，则赋值给 value_string_ 或 value_number_
-            JsonTokenType scan();
+            // 输入有误时抛出 ParseException
+            JsonTokenType scan()
+            {
+                JsonTokenType token = this->tryScan();
+                if (token == JsonTokenType::INVALID_INPUT)
+                {
+                    throw ParseException(this->error_);
+                }
+                return token;
+            }
+
+            // 不抛出异常的 scan()，输入有误时返回 INVALID_INPUT，错误及其位置由 lastError() 取得
+            JsonTokenType tryScan();
+
+            // 最近一次返回 INVALID_INPUT 时的错误
+            const ParseError &lastError() { return this->error_; }
+
+            // 构造位于 offset 处的错误，行号与列号由 offset 在 source 中换算，只在出错时计算
+            ParseError makeError(ErrorCode code, const char *message, size_t offset);
 
             // 回滚到上一个 token
             void rollback();
 
-            // 获取 value_number_
-            float getNumberValue() { return this->value_number_; }
+            // 先用 StructuralIndexer 一次性找出所有 token 的起始位置，
+            // 之后 scan() 直接跳到下一个 token，不再逐个字符跳过空白
+            // 结果与逐字符扫描完全一致
+            void buildIndex();
 
-            // 获取
-            std::string getStringValue() { return this->value_string_; }
+            // 分段模式：source 只是输入的一部分，结尾处不完整的 token 不报错，
+            // scan() 停在该 token 的起始位置并返回 END_OF_SOURCE，等待后续数据
+            void partial(bool partial) { this->partial_ = partial; }
+
+            // scan() 返回 { 或 [ 之后调用，直接跳到与之匹配的 } 或 ] 之后
+            // 只做括号配对并跳过字符串，不解析也不校验其中的内容，用于快速略过不需要的子树
+            void skip();
+
+            // 跳到 position，下一次 scan() 从这里开始
+            void seek(size_t position);
+
+            // 当前扫描到的位置，之前的内容都已经被消费
+            size_t position() { return this->current_; }
+
+            // 最近一次 scan() 得到的 token 的起始位置，已跳过之前的空白
+            size_t tokenPosition() { return this->token_pos_; }
+
+            // 获取 value_number_，转为 double
+            double getNumberValue() { return this->value_number_.toDouble(); }
+
+            // 获取 value_number_，整数保持精确
+            const Number &getNumber() { return this->value_number_; }
+
+            // 获取字符串的值，会分配一个新的 std::string
+            std::string getStringValue() { return std::string(this->value_string_); }
+
+            // 获取解码后的字符串，保证是合法的 UTF-8，不含转义字符时直接指向 source 中的内容，不拷贝，
+            // 仅在 source 有效且下一次 scan() 之前有效
+            std::string_view getStringView() { return this->value_string_; }
 
         private:
+            // 持有模式下 source 的存储，拷贝 Scanner 时共享，不会再次拷贝
+            std::shared_ptr<const std::string> owned_;
             // json source
-            std::string source_;
+            std::string_view source_;
             // 当前正在处理的索引
-            size_t current_;
-            // 保存字符串的值
-            std::string value_string_;
+            size_t current_ = 0;
+            // 保存字符串的值，指向 source_ 的一段或 value_buffer_
+            std::string_view value_string_;
+            // 含有转义字符的字符串解码后的结果，复用同一块内存
+            std::string value_buffer_;
             // 保存数字的值
-            float value_number_;
-            // 前一个字符索引
-            size_t prev_pos_;
-            // 当前行
-            size_t line_;
+            Number value_number_;
+            // 前一个 token 的起始索引
+            size_t prev_pos_ = 0;
+            // 当前 token 的起始索引
+            size_t token_pos_ = 0;
+            // token 起始位置索引，为空表示逐字符扫描
+            std::shared_ptr<const std::vector<uint32_t>> index_;
+            // 下一个 token 在 index_ 中的下标
+            size_t index_pos_ = 0;
+            // 前一个 token 在 index_ 中的下标，用于回滚
+            size_t prev_index_pos_ = 0;
+            // 分段模式
+            bool partial_ = false;
+            // 分段模式下，当前 token 在 source 结尾处被截断
+            bool incomplete_ = false;
+            // 当前 token 扫描出错，错误保存在 error_ 中
+            bool failed_ = false;
+            ParseError error_;
 
         private:
             // 是否到达结尾
             bool isAtEnd();
 
+            // 记录当前 token 的错误，由 endScalar() 转换为 INVALID_INPUT
+            void fail(ErrorCode code, const char *message, size_t offset);
+
             // 移动，并返回下一个字符
             char advance();
 
+            // 扫描 true/false/null 首字符之后的部分
+            void scanLiteral(std::string_view rest, const char *message);
+
+            // 值类型 token 扫描结束后的处理
+            JsonTokenType endScalar(JsonTokenType type, size_t start);
+
             // 扫描判断是否是 true
             void scanTrue();
 
@@ -169,9 +263,18 @@ namespace civitasv
             // 扫描判断是否是 string 类型
             void scanString();
 
+            // 解码 p 处以 `\` 开头的一个转义字符，追加到 value_buffer_ 中，返回其后的位置
+            // \uXXXX 解码为 UTF-8，代理对合并为一个字符，单独的代理项报错
+            // 在 last 处被截断时返回 nullptr
+            const char *unescape(const char *p, const char *last);
+
             // 判断是否是数字
             bool isDigit(char c);
 
+            // 索引模式下，number/true/false/null 之后必须紧跟空白、结构字符或引号，
+            // 否则索引与逐字符扫描的切分不一致，退回逐字符扫描
+            void checkScalarEnd();
+
             // 当前字符
             char peek();
 
@@ -0,0 +1,164 @@
+#include "streamParser.h"
+#include "scanner.h"
+#include "error.h"
+
+#include <algorithm>
+
+namespace civitasv
+{
+    namespace json
+    {
+        using JsonTokenType = Scanner::JsonTokenType;
+
+        // 喂入一段数据
+        StreamParser::Status StreamParser::feed(std::string_view bytes)
+        {
+            // 没有被切断的 token 时直接在 bytes 上扫描，不拷贝
+            if (this->pending_.empty())
+            {
+                return this->run(bytes, false);
+            }
+
+            this->pending_.append(bytes);
+            if (this->cut_ != 0 && !this->mayComplete(bytes))
+            {
+                return Status::NEED_MORE;
+            }
+            std::string source = std::move(this->pending_);
+            this->pending_.clear();
+            return this->run(source, false);
+        }
+
+        // 输入结束
+        StreamParser::Status StreamParser::finish()
+        {
+            std::string source = std::move(this->pending_);
+            this->pending_.clear();
+            return this->run(source, true);
+        }
+
+        // 在 source 上尽可能多地推进
+        StreamParser::Status StreamParser::run(std::string_view source, bool last)
+        {
+            Scanner scanner(source);
+            scanner.partial(!last);
+
+            Status status = Status::NEED_MORE;
+            try
+            {
+                while (!this->reader_.complete())
+                {
+                    JsonTokenType token = scanner.scan();
+                    if (token == JsonTokenType::END_OF_SOURCE)
+                    {
+                        if (last && !this->reader_.empty())
+                        {
+                            throw ParseException(scanner.makeError(ErrorCode::UNEXPECTED_END, "Unexpected end of source!", source.size()));
+                        }
+                        break;
+                    }
+
+                    if (!this->reader_.consume(token, scanner, this->handler_))
+                    {
+                        status = Status::STOPPED;
+                        break;
+                    }
+                }
+            }
+            catch (const ParseException &e)
+            {
+                throw ParseException(this->locate(e.error()));
+            }
+
+            if (this->reader_.complete())
+            {
+                status = Status::COMPLETE;
+            }
+
+            // 已消费的部分计入位置，保存未消费的部分
+            std::string_view consumed = source.substr(0, scanner.position());
+            size_t newline = consumed.rfind('\n');
+            if (newline != std::string_view::npos)
+            {
+                this->line_ += std::count(consumed.begin(), consumed.end(), '\n');
+                this->column_ = consumed.size() - newline;
+            }
+            else
+            {
+                this->column_ += consumed.size();
+            }
+            this->offset_ += consumed.size();
+            this->pending_.assign(source.substr(scanner.position()));
+            this->cut_ = 0;
+            if (status == Status::NEED_MORE && !last)
+            {
+                this->markCut();
+            }
+            return status;
+        }
+
+        // 记录被切断的 token
+        void StreamParser::markCut()
+        {
+            // scanner 停在被切断的 token 的起始位置
+            size_t start = this->pending_.find_first_not_of(" \t\r\n");
+            if (start == std::string::npos)
+            {
+                return;
+            }
+            char c = this->pending_[start];
+            if (c == '\"')
+            {
+                this->cut_ = '\"';
+                this->escaped_ = false;
+                // 只有不可能结束时才会停在这里，因此其中没有未转义的 " 与控制字符，只需要转义状态
+                this->mayComplete(std::string_view(this->pending_).substr(start + 1));
+            }
+            else if (c == '-' || (c >= '0' && c <= '9'))
+            {
+                this->cut_ = '0';
+            }
+        }
+
+        // 被切断的 token 是否可能已经结束
+        bool StreamParser::mayComplete(std::string_view bytes)
+        {
+            if (this->cut_ == '0')
+            {
+                // 数字中可能出现的字符之外的任何字节都让数字结束
+                return bytes.find_first_not_of("0123456789+-.eE") != std::string_view::npos;
+            }
+
+            // 字符串在未转义的 " 处结束，控制字符让扫描立即报错
+            for (char c : bytes)
+            {
+                if (this->escaped_)
+                {
+                    this->escaped_ = false;
+                }
+                else if (c == '\\')
+                {
+                    this->escaped_ = true;
+                }
+                else if (c == '\"' || (unsigned char)c < 0x20)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // 换算为相对于整个输入的位置
+        ParseError StreamParser::locate(const ParseError &error)
+        {
+            ParseError result = error;
+            result.offset += this->offset_;
+            if (error.line == 1)
+            {
+                result.column += this->column_ - 1;
+            }
+            result.line += this->line_ - 1;
+            return result;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "reader.h"
+#include "handler.h"
+#include "error.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 可恢复的分段解析器，输入可以按任意位置切分后逐段 feed()
+        // 语法状态保存在 Reader 中，只缓存被切断的最后一个 token，不缓存整个文档
+        // 事件通过 handler 回调，需要 DOM 时传入 TreeBuilder
+        class StreamParser
+        {
+        public:
+            enum class Status
+            {
+                // 值还不完整，需要更多数据
+                NEED_MORE,
+                // 已经读完一个完整的值
+                COMPLETE,
+                // handler 要求停止
+                STOPPED
+            };
+
+            explicit StreamParser(JsonHandler &handler, size_t max_depth = Reader::DEFAULT_MAX_DEPTH)
+                : handler_(handler), reader_(max_depth) {}
+
+            // 喂入一段数据，输入有误时抛出 ParseException，位置相对于整个输入
+            Status feed(std::string_view bytes);
+
+            // 输入结束，结尾处的数字、字面量此时才能确定已经结束
+            // 没有读到任何值时返回 NEED_MORE，值不完整时报错
+            Status finish();
+
+            // 准备读取下一个值，上一个值之后尚未消费的数据会保留，可以 feed({}) 继续处理
+            void reset() { this->reader_.reset(); }
+
+            // 上一个值之后尚未消费的数据
+            std::string_view remaining() { return this->pending_; }
+
+        private:
+            // 在 source 上尽可能多地推进，剩余部分保存到 pending_
+            Status run(std::string_view source, bool last);
+
+            // 将相对于本段 source 的错误位置换算为相对于整个输入
+            ParseError locate(const ParseError &error);
+
+            // 记录 pending_ 中被切断的 token 是字符串还是数字，以及字符串结尾处的转义状态
+            void markCut();
+
+            // 只检查新到的 bytes，判断被切断的 token 是否可能已经结束
+            // 不可能结束时不再从头扫描整个 pending_，跨越很多段的长 token 每个字节只检查一次
+            bool mayComplete(std::string_view bytes);
+
+        private:
+            JsonHandler &handler_;
+            Reader reader_;
+            // 被切断的 token 以及完成后尚未消费的数据
+            std::string pending_;
+            // 被切断的 token：'"' 为字符串，'0' 为数字，0 表示没有或每次都重新扫描（字面量很短）
+            char cut_ = 0;
+            // 字符串中最后一个字节是尚未配对的 '\'
+            bool escaped_ = false;
+            // 本段 source 起始处在整个输入中的偏移、行号与列号
+            size_t offset_ = 0;
+            size_t line_ = 1;
+            size_t column_ = 1;
+        };
+    }
+}
@@ -0,0 +1,306 @@
+#include "structuralIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CIVITASV_JSON_X86 1
+#include <immintrin.h>
+#endif
+
+namespace civitasv
+{
+    namespace json
+    {
+        namespace
+        {
+            // 一块 64 字节中各类字符的位图，第 i 位对应第 i 个字节
+            struct BlockMasks
+            {
+                uint64_t backslash;
+                uint64_t quote;
+                uint64_t whitespace;
+                uint64_t structural;
+            };
+
+            using Classifier = void (*)(const char *block, BlockMasks &masks);
+
+            // 逐字节分类
+            void classifyScalar(const char *block, BlockMasks &masks)
+            {
+                masks = BlockMasks{0, 0, 0, 0};
+                for (int i = 0; i < 64; i++)
+                {
+                    uint64_t bit = uint64_t(1) << i;
+                    switch (block[i])
+                    {
+                    case '\\':
+                        masks.backslash |= bit;
+                        break;
+                    case '\"':
+                        masks.quote |= bit;
+                        break;
+                    case ' ':
+                    case '\t':
+                    case '\n':
+                    case '\r':
+                        masks.whitespace |= bit;
+                        break;
+                    case '{':
+                    case '}':
+                    case '[':
+                    case ']':
+                    case ':':
+                    case ',':
+                        masks.structural |= bit;
+                        break;
+                    default:
+                        break;
+                    }
+                }
+            }
+
+#if CIVITASV_JSON_X86
+#if defined(__GNUC__)
+#define CIVITASV_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CIVITASV_TARGET(isa)
+#endif
+
+            CIVITASV_TARGET("sse2")
+            void classifySse2(const char *block, BlockMasks &masks)
+            {
+                masks = BlockMasks{0, 0, 0, 0};
+                for (int i = 0; i < 4; i++)
+                {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * 16));
+#define EQ(c) _mm_cmpeq_epi8(v, _mm_set1_epi8(c))
+                    __m128i ws = _mm_or_si128(_mm_or_si128(EQ(' '), EQ('\t')), _mm_or_si128(EQ('\n'), EQ('\r')));
+                    __m128i st = _mm_or_si128(_mm_or_si128(EQ('{'), EQ('}')), _mm_or_si128(EQ('['), EQ(']')));
+                    st = _mm_or_si128(st, _mm_or_si128(EQ(':'), EQ(',')));
+
+                    int shift = i * 16;
+                    masks.backslash |= uint64_t(uint16_t(_mm_movemask_epi8(EQ('\\')))) << shift;
+                    masks.quote |= uint64_t(uint16_t(_mm_movemask_epi8(EQ('\"')))) << shift;
+#undef EQ
+                    masks.whitespace |= uint64_t(uint16_t(_mm_movemask_epi8(ws))) << shift;
+                    masks.structural |= uint64_t(uint16_t(_mm_movemask_epi8(st))) << shift;
+                }
+            }
+
+#if defined(__GNUC__)
+            CIVITASV_TARGET("avx2")
+            void classifyAvx2(const char *block, BlockMasks &masks)
+            {
+                masks = BlockMasks{0, 0, 0, 0};
+                for (int i = 0; i < 2; i++)
+                {
+                    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i * 32));
+#define EQ(c) _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))
+                    __m256i ws = _mm256_or_si256(_mm256_or_si256(EQ(' '), EQ('\t')), _mm256_or_si256(EQ('\n'), EQ('\r')));
+                    __m256i st = _mm256_or_si256(_mm256_or_si256(EQ('{'), EQ('}')), _mm256_or_si256(EQ('['), EQ(']')));
+                    st = _mm256_or_si256(st, _mm256_or_si256(EQ(':'), EQ(',')));
+
+                    int shift = i * 32;
+                    masks.backslash |= uint64_t(uint32_t(_mm256_movemask_epi8(EQ('\\')))) << shift;
+                    masks.quote |= uint64_t(uint32_t(_mm256_movemask_epi8(EQ('\"')))) << shift;
+#undef EQ
+                    masks.whitespace |= uint64_t(uint32_t(_mm256_movemask_epi8(ws))) << shift;
+                    masks.structural |= uint64_t(uint32_t(_mm256_movemask_epi8(st))) << shift;
+                }
+            }
+#endif
+#endif
+
+            inline int trailingZeros(uint64_t x)
+            {
+#if defined(__GNUC__)
+                return __builtin_ctzll(x);
+#else
+                int n = 0;
+                while ((x & 1) == 0)
+                {
+                    x >>= 1;
+                    n++;
+                }
+                return n;
+#endif
+            }
+
+            // 跨块保存的状态
+            struct IndexState
+            {
+                // 上一块最后一个字符是未被转义的 `\`
+                uint64_t prev_escaped = 0;
+                // 上一块结束时在字符串内部，全 1 或全 0
+                uint64_t prev_in_string = 0;
+                // 上一块最后一个字符是空白、结构字符或字符串结束引号，文档开头视为是
+                uint64_t prev_boundary = 1;
+            };
+
+            // 被 `\` 转义的字符位图，`\` 很少出现，逐位处理即可
+            inline uint64_t escapedMask(uint64_t backslash, IndexState &state)
+            {
+                uint64_t escaped = 0;
+                if (state.prev_escaped)
+                {
+                    escaped |= 1;
+                    backslash &= ~uint64_t(1);
+                }
+                state.prev_escaped = 0;
+
+                while (backslash != 0)
+                {
+                    int i = trailingZeros(backslash);
+                    if (i == 63)
+                    {
+                        state.prev_escaped = 1;
+                    }
+                    else
+                    {
+                        // 被转义的 `\` 不再转义下一个字符
+                        escaped |= uint64_t(1) << (i + 1);
+                        backslash &= ~(uint64_t(1) << (i + 1));
+                    }
+                    backslash &= backslash - 1;
+                }
+
+                return escaped;
+            }
+
+            // 处理一块，返回 token 起始位置的位图
+            inline uint64_t blockStarts(const BlockMasks &masks, IndexState &state)
+            {
+                uint64_t quote = masks.quote;
+                if (masks.backslash != 0 || state.prev_escaped)
+                {
+                    quote &= ~escapedMask(masks.backslash, state);
+                }
+
+                // 前缀异或，得到字符串内部（含起始引号，不含结束引号）的位图
+                uint64_t in_string = quote;
+                in_string ^= in_string << 1;
+                in_string ^= in_string << 2;
+                in_string ^= in_string << 4;
+                in_string ^= in_string << 8;
+                in_string ^= in_string << 16;
+                in_string ^= in_string << 32;
+                in_string ^= state.prev_in_string;
+                state.prev_in_string = uint64_t(int64_t(in_string) >> 63);
+
+                uint64_t structural = masks.structural & ~in_string;
+                uint64_t whitespace = masks.whitespace & ~in_string;
+                uint64_t open_quote = quote & in_string;
+                uint64_t close_quote = quote & ~in_string;
+
+                // number/true/false/null 的首字符：紧跟在空白、结构字符或字符串之后
+                uint64_t boundary = structural | whitespace | close_quote;
+                uint64_t follows_boundary = (boundary << 1) | state.prev_boundary;
+                state.prev_boundary = boundary >> 63;
+                uint64_t scalar = ~(structural | whitespace | quote | in_string);
+
+                return structural | open_quote | (scalar & follows_boundary);
+            }
+
+            template <Classifier classify>
+            void indexBlocks(std::string_view source, std::vector<uint32_t> &out)
+            {
+                IndexState state;
+                BlockMasks masks;
+                size_t size = source.size();
+                size_t count = 0;
+
+                auto flatten = [&](uint64_t starts, size_t base)
+                {
+                    // 每块最多 64 个 token，预留足够空间后直接写入
+                    if (count + 64 > out.size())
+                    {
+                        out.resize(std::max(out.size() * 2, count + 64));
+                    }
+                    uint32_t *dst = out.data() + count;
+                    while (starts != 0)
+                    {
+                        *dst++ = uint32_t(base + trailingZeros(starts));
+                        starts &= starts - 1;
+                    }
+                    count = dst - out.data();
+                };
+
+                size_t pos = 0;
+                for (; pos + 64 <= size; pos += 64)
+                {
+                    classify(source.data() + pos, masks);
+                    flatten(blockStarts(masks, state), pos);
+                }
+
+                // 最后不足 64 字节的部分用空白补齐
+                if (pos < size)
+                {
+                    char tail[64];
+                    std::memset(tail, ' ', sizeof(tail));
+                    std::memcpy(tail, source.data() + pos, size - pos);
+                    classify(tail, masks);
+                    flatten(blockStarts(masks, state), pos);
+                }
+
+                out.resize(count);
+            }
+        }
+
+        StructuralIndexer::Implementation StructuralIndexer::best()
+        {
+#if CIVITASV_JSON_X86 && defined(__GNUC__)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return Implementation::AVX2;
+            }
+            if (__builtin_cpu_supports("sse2"))
+            {
+                return Implementation::SSE2;
+            }
+#elif CIVITASV_JSON_X86 && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+            return Implementation::SSE2;
+#endif
+            return Implementation::SCALAR;
+        }
+
+        bool StructuralIndexer::index(std::string_view source, std::vector<uint32_t> &out)
+        {
+            if (source.size() >= std::numeric_limits<uint32_t>::max())
+            {
+                return false;
+            }
+
+            out.clear();
+            // 经验值：token 数通常不超过字节数的 1/4
+            out.resize(source.size() / 4 + 64);
+
+            switch (this->implementation_)
+            {
+#if CIVITASV_JSON_X86
+#if defined(__GNUC__)
+            case Implementation::AVX2:
+            {
+                indexBlocks<classifyAvx2>(source, out);
+                break;
+            }
+#endif
+            case Implementation::SSE2:
+            {
+                indexBlocks<classifySse2>(source, out);
+                break;
+            }
+#endif
+            default:
+            {
+                indexBlocks<classifyScalar>(source, out);
+                break;
+            }
+            }
+
+            return true;
+        }
+    }
+}
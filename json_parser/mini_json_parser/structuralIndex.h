@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 两阶段解析的第一阶段：一次性找出所有 token 的起始位置
+        // 包括字符串外的 {}[]:, 、字符串的起始引号以及 number/true/false/null 的首字符
+        // 每 64 字节为一块，用 SIMD 生成字符位图，再用位运算处理转义与引号内外
+        class StructuralIndexer
+        {
+        public:
+            enum class Implementation
+            {
+                SCALAR,
+                SSE2,
+                AVX2
+            };
+
+            // 运行时检测 CPU 支持的最快实现
+            static Implementation best();
+
+            explicit StructuralIndexer(Implementation implementation = best())
+                : implementation_(implementation) {}
+
+            Implementation implementation() { return this->implementation_; }
+
+            // 将 source 中所有 token 的起始位置写入 out
+            // source 超过 4GB 时返回 false，调用方应退回逐字符扫描
+            bool index(std::string_view source, std::vector<uint32_t> &out);
+
+        private:
+            Implementation implementation_;
+        };
+    }
+}
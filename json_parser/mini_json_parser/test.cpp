@@ -1,18 +1,39 @@
+#include <chrono>
 #include <iostream>
 #include "parser.h"
 #include "scanner.h"
+#include "handler.h"
+#include "query.h"
+#include "lazyDocument.h"
+#include "msgpack.h"
+#include "streamParser.h"
 
 using namespace civitasv::json;
 
 void test_scanner();
 void test_parser();
+void test_reader();
+void test_query();
+void test_lazy();
+void test_msgpack();
+void test_stream();
 
 int main()
 {
-    // g++ -o main test.cpp scanner.cpp parser.cpp -std=c++17 && ./main
+    // g++ -o main test.cpp scanner.cpp parser.cpp structuralIndex.cpp number.cpp reader.cpp treeBuilder.cpp writer.cpp query.cpp lazyDocument.cpp utf8.cpp msgpack.cpp streamParser.cpp -std=c++17 && ./main
     test_scanner();
     std::cout << "======================>\n";
     test_parser();
+    std::cout << "======================>\n";
+    test_reader();
+    std::cout << "======================>\n";
+    test_query();
+    std::cout << "======================>\n";
+    test_lazy();
+    std::cout << "======================>\n";
+    test_msgpack();
+    std::cout << "======================>\n";
+    test_stream();
 
     return 0;
 }
@@ -79,3 +100,159 @@ void test_parser()
         std::cout << '\n';
     }
 }
+
+// 只打印事件，不构建 DOM
+class PrintHandler : public JsonHandler
+{
+public:
+    bool onNull() override { return print("null"); }
+
+    bool onBool(bool value) override { return print(value ? "true" : "false"); }
+
+    bool onNumber(const Number &value) override { return print("number " + std::to_string(value.toDouble())); }
+
+    bool onString(std::string_view value) override { return print("string " + std::string(value)); }
+
+    bool onKey(std::string_view key) override { return print("key " + std::string(key)); }
+
+    bool onStartObject() override { return print("{"); }
+
+    bool onEndObject() override { return print("}"); }
+
+    bool onStartArray() override { return print("["); }
+
+    bool onEndArray() override { return print("]"); }
+
+private:
+    bool print(const std::string &event)
+    {
+        std::cout << "Event: " << event << '\n';
+        return true;
+    }
+};
+
+void test_reader()
+{
+    auto source = R"({"glossary": {"test": true, "hello": null, "list": [1, 2.5, "miao"]}})";
+
+    PrintHandler handler;
+    Parser parser(source);
+    parser.parse(handler);
+}
+
+void test_query()
+{
+    auto source = R"({"glossary": {"test": true, "hello": null, "hello2": "miao\"miao"}, "list": [{"k": 1}, {"k": [2, 3]}]})";
+
+    // 只解析匹配的值，其余子树直接跳过
+    Scanner scanner(source);
+    Query query(JsonPath::fromPointer("/glossary/hello2"));
+    JsonElement *hello2 = query.first(scanner);
+    std::cout << "/glossary/hello2: " << hello2->dumps() << '\n';
+    delete hello2;
+
+    Scanner scanner2(source);
+    Query query2(JsonPath::fromPath("$.list[*].k"));
+    for (auto element : query2.select(scanner2))
+    {
+        std::cout << "$.list[*].k: " << element->dumps() << '\n';
+        delete element;
+    }
+
+    // 在已经解析好的树上查找
+    Parser parser(source);
+    JsonElement *root = parser.parse();
+    std::cout << "/list/1/k/0: " << find(root, "/list/1/k/0")->dumps() << '\n';
+    delete root;
+}
+
+void test_lazy()
+{
+    std::string source = R"({"glossary": {"test": true, "hello": null, "hello2": "miao\"miao"}, "list": [1, 2.5, "miao"]})";
+
+    // 只展开访问到的对象，list 中的内容不会被解析
+    LazyDocument document(source);
+    LazyValue *glossary = document.root()->find("glossary");
+    std::cout << "hello2: " << glossary->find("hello2")->asString() << '\n';
+    std::cout << "test: " << glossary->find("test")->asBool() << '\n';
+}
+
+void test_msgpack()
+{
+    std::string source = R"({"glossary": {"test": true, "hello": null, "hello2": "miao\"miao"}, "list": [1, -200, 2.5, 18446744073709551615]})";
+    Parser parser{Scanner(std::string_view(source))};
+    JsonElement *root = parser.parse();
+
+    // 编码为 MessagePack 后再读回来
+    std::string binary;
+    MsgpackWriter(binary).write(root);
+    std::cout << "msgpack: " << binary.size() << " bytes, text: " << source.size() << " bytes\n";
+
+    JsonElement *copy = MsgpackReader(binary).parse();
+    std::cout << copy->dumps() << '\n';
+
+    delete root;
+    delete copy;
+}
+
+void test_stream()
+{
+    // 跨越很多段的长字符串与长数字：每个字节只检查一次，耗时随长度线性增长
+    struct Lengths : JsonHandler
+    {
+        size_t string = 0;
+        double number = 0;
+        bool onString(std::string_view value) override
+        {
+            this->string = value.size();
+            return true;
+        }
+        bool onNumber(const Number &value) override
+        {
+            this->number = value.float64;
+            return true;
+        }
+    };
+
+    for (size_t mb : {1, 4, 16})
+    {
+        // 转义字符被切在段的边界上
+        std::string text(mb << 20, 'a');
+        for (size_t i = 4094; i < text.size(); i += 4096)
+        {
+            text[i - 1] = '\\';
+            text[i] = '\"';
+        }
+        std::string source = "[\"" + text + "\", 0." + std::string(mb << 20, '5') + "]";
+
+        Lengths handler;
+        StreamParser parser(handler);
+        auto start = std::chrono::steady_clock::now();
+        StreamParser::Status status = StreamParser::Status::NEED_MORE;
+        for (size_t pos = 0; pos < source.size(); pos += 4096)
+        {
+            status = parser.feed(std::string_view(source).substr(pos, 4096));
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (status != StreamParser::Status::COMPLETE || handler.string != text.size() - text.size() / 4096 || handler.number != 0.5555555555555556)
+        {
+            error("stream: long token mismatch");
+        }
+        std::cout << "stream: " << mb << " MB string + " << mb << " MB number in 4 KB chunks: " << seconds * 1000 << " ms\n";
+    }
+
+    // 被推迟扫描的 token 出错时，位置仍然相对于整个输入
+    Lengths handler;
+    StreamParser parser(handler);
+    try
+    {
+        parser.feed("[\"abc");
+        parser.feed("de\\x");
+        parser.feed("yz\"]");
+        error("stream: bad escape not reported");
+    }
+    catch (const ParseException &e)
+    {
+        std::cout << "stream: " << e.what() << '\n';
+    }
+}
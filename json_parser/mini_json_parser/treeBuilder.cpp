@@ -0,0 +1,143 @@
+#include "treeBuilder.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        using Type = JsonElement::Type;
+
+        // 取出构建好的根节点
+        JsonElement *TreeBuilder::release()
+        {
+            JsonElement *root = this->root_;
+            this->root_ = nullptr;
+            this->stack_.clear();
+            return root;
+        }
+
+        // 丢弃构建到一半的树
+        void TreeBuilder::reset(std::pmr::memory_resource *resource)
+        {
+            this->discard();
+            this->resource_ = resource;
+        }
+
+        void TreeBuilder::discard()
+        {
+            // 已经挂到根节点上的子节点随根节点一起释放
+            if (this->resource_ == nullptr)
+            {
+                delete this->root_;
+            }
+            this->root_ = nullptr;
+            this->stack_.clear();
+        }
+
+        // 为当前容器预留空间
+        void TreeBuilder::reserve(size_t size)
+        {
+            if (this->stack_.empty())
+            {
+                return;
+            }
+            JsonElement *container = this->stack_.back().container;
+            if (container->type() == Type::JSON_OBJECT)
+            {
+                container->asObject()->reserve(size);
+            }
+            else
+            {
+                container->asArray()->reserve(size);
+            }
+        }
+
+        bool TreeBuilder::onNull()
+        {
+            this->attach(this->create<JsonElement>());
+            return true;
+        }
+
+        bool TreeBuilder::onBool(bool value)
+        {
+            this->attach(this->create<JsonElement>(value));
+            return true;
+        }
+
+        bool TreeBuilder::onNumber(const Number &value)
+        {
+            this->attach(this->create<JsonElement>(value));
+            return true;
+        }
+
+        bool TreeBuilder::onString(std::string_view value)
+        {
+            JsonString *val = this->create<JsonString>(value, this->resource());
+            this->attach(this->create<JsonElement>(val));
+            return true;
+        }
+
+        bool TreeBuilder::onKey(std::string_view key)
+        {
+            this->stack_.back().key = key;
+            return true;
+        }
+
+        bool TreeBuilder::onStartObject()
+        {
+            JsonElement *element = this->create<JsonElement>(this->create<JsonObject>(this->resource()));
+            this->attach(element);
+            this->stack_.push_back(Frame{element, JsonString(this->resource())});
+            return true;
+        }
+
+        bool TreeBuilder::onEndObject()
+        {
+            this->stack_.pop_back();
+            return true;
+        }
+
+        bool TreeBuilder::onStartArray()
+        {
+            JsonElement *element = this->create<JsonElement>(this->create<JsonArray>(this->resource()));
+            this->attach(element);
+            this->stack_.push_back(Frame{element, JsonString(this->resource())});
+            return true;
+        }
+
+        bool TreeBuilder::onEndArray()
+        {
+            this->stack_.pop_back();
+            return true;
+        }
+
+        // 将新值挂到当前容器上
+        void TreeBuilder::attach(JsonElement *element)
+        {
+            if (this->stack_.empty())
+            {
+                if (this->resource_ == nullptr)
+                {
+                    delete this->root_;
+                }
+                this->root_ = element;
+                return;
+            }
+
+            Frame &top = this->stack_.back();
+            if (top.container->type() == Type::JSON_OBJECT)
+            {
+                // 重复的 key 以后者为准，位置保持第一次出现时的顺序
+                JsonElement *&slot = (*top.container->asObject())[top.key];
+                if (slot != nullptr && this->resource_ == nullptr)
+                {
+                    delete slot;
+                }
+                slot = element;
+            }
+            else
+            {
+                top.container->asArray()->push_back(element);
+            }
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include "handler.h"
+#include "jsonElement.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 由 SAX 事件构建 JsonElement 树的 handler
+        // resource 为空时节点逐个 new，否则全部分配在 resource（如 Document 的 arena）上
+        class TreeBuilder : public JsonHandler
+        {
+        public:
+            explicit TreeBuilder(std::pmr::memory_resource *resource = nullptr) : resource_(resource) {}
+
+            ~TreeBuilder() override { this->discard(); }
+
+            TreeBuilder(const TreeBuilder &) = delete;
+            TreeBuilder &operator=(const TreeBuilder &) = delete;
+
+            // 取出构建好的根节点，所有权交给调用方，尚未收到任何值时返回 nullptr
+            JsonElement *release();
+
+            // 丢弃构建到一半的树，并切换到新的 resource
+            void reset(std::pmr::memory_resource *resource = nullptr);
+
+            // 为当前容器预留 size 个成员的空间，用于事先知道成员数的格式（如 MessagePack）
+            void reserve(size_t size);
+
+            bool onNull() override;
+
+            bool onBool(bool value) override;
+
+            bool onNumber(const Number &value) override;
+
+            bool onString(std::string_view value) override;
+
+            bool onKey(std::string_view key) override;
+
+            bool onStartObject() override;
+
+            bool onEndObject() override;
+
+            bool onStartArray() override;
+
+            bool onEndArray() override;
+
+        private:
+            // 显式栈中的一层，对应一个未闭合的对象或数组
+            struct Frame
+            {
+                JsonElement *container;
+                // 对象中正在解析的 key
+                JsonString key;
+            };
+
+            // 创建节点、容器或字符串，resource_ 为空时走堆
+            template <class T, class... Args>
+            T *create(Args &&...args)
+            {
+                if (this->resource_ == nullptr)
+                {
+                    return new T(std::forward<Args>(args)...);
+                }
+                void *p = this->resource_->allocate(sizeof(T), alignof(T));
+                return new (p) T(std::forward<Args>(args)...);
+            }
+
+            // 容器和字符串使用的分配器
+            std::pmr::memory_resource *resource()
+            {
+                return this->resource_ != nullptr ? this->resource_ : std::pmr::get_default_resource();
+            }
+
+            // 将新值挂到当前容器上，栈为空时作为根节点
+            void attach(JsonElement *element);
+
+            // 丢弃构建到一半的树，arena 上的节点由其所有者整体释放
+            void discard();
+
+        private:
+            // 当前使用的 arena，为空表示堆分配
+            std::pmr::memory_resource *resource_;
+            JsonElement *root_ = nullptr;
+            // 未闭合的容器
+            std::vector<Frame> stack_;
+        };
+    }
+}
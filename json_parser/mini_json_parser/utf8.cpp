@@ -0,0 +1,117 @@
+#include "utf8.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define CIVITASV_JSON_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace civitasv
+{
+    namespace json
+    {
+        namespace
+        {
+            // x 不为 0
+            inline int trailingZeros(uint32_t x)
+            {
+#if defined(__GNUC__)
+                return __builtin_ctz(x);
+#else
+                int n = 0;
+                while ((x & 1) == 0)
+                {
+                    x >>= 1;
+                    n++;
+                }
+                return n;
+#endif
+            }
+        }
+
+        // 找到第一个需要单独处理的字节
+        const char *findStringSpecial(const char *first, const char *last)
+        {
+#if defined(CIVITASV_JSON_SSE2)
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i space = _mm_set1_epi8(0x20);
+            while (last - first >= 16)
+            {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+                // 有符号比较，小于 0x20 的控制字符与大于等于 0x80 的字节一起被找出
+                __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+                                               _mm_cmplt_epi8(block, space));
+                int mask = _mm_movemask_epi8(special);
+                if (mask != 0)
+                {
+                    return first + trailingZeros(uint32_t(mask));
+                }
+                first += 16;
+            }
+#endif
+            while (first != last)
+            {
+                unsigned char c = *first;
+                if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80)
+                {
+                    return first;
+                }
+                first++;
+            }
+            return last;
+        }
+
+        // 整段校验 UTF-8
+        bool validateUtf8(std::string_view source)
+        {
+            const char *p = source.data();
+            const char *last = p + source.size();
+            while (p != last)
+            {
+                // ASCII 直接跳过，包括 findStringSpecial 会停下的引号与控制字符
+                p = findStringSpecial(p, last);
+                if (p == last)
+                {
+                    break;
+                }
+                if ((unsigned char)*p < 0x80)
+                {
+                    p++;
+                    continue;
+                }
+                bool truncated;
+                p = skipUtf8(p, last, truncated);
+                if (p == nullptr || truncated)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // 将 unicode 码点编码为 UTF-8
+        void appendUtf8(std::string &out, uint32_t code)
+        {
+            if (code < 0x80)
+            {
+                out.push_back(char(code));
+            }
+            else if (code < 0x800)
+            {
+                char bytes[2] = {char(0xC0 | (code >> 6)), char(0x80 | (code & 0x3F))};
+                out.append(bytes, 2);
+            }
+            else if (code < 0x10000)
+            {
+                char bytes[3] = {char(0xE0 | (code >> 12)), char(0x80 | ((code >> 6) & 0x3F)), char(0x80 | (code & 0x3F))};
+                out.append(bytes, 3);
+            }
+            else
+            {
+                char bytes[4] = {char(0xF0 | (code >> 18)), char(0x80 | ((code >> 12) & 0x3F)),
+                                 char(0x80 | ((code >> 6) & 0x3F)), char(0x80 | (code & 0x3F))};
+                out.append(bytes, 4);
+            }
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 返回 [first, last) 中第一个字符串里需要单独处理的字节：`"`、`\`、控制字符或非 ASCII 字节，
+        // 没有时返回 last；支持 SSE2 时每次检查 16 字节，ASCII 文本整段跳过
+        const char *findStringSpecial(const char *first, const char *last);
+
+        // 校验 first 开头的一个多字节 UTF-8 字符，返回其后的位置
+        // 拒绝过长编码、代理项与超过 U+10FFFF 的码点，格式错误返回 nullptr
+        // 在 last 处被截断时 truncated 为 true，返回 last
+        // 每个非 ASCII 字符都会调用，定义在头文件中以便内联
+        inline const char *skipUtf8(const char *first, const char *last, bool &truncated)
+        {
+            truncated = false;
+            // 后续字节数与第二个字节的取值范围
+            unsigned char c = *first;
+            int count;
+            unsigned char low = 0x80;
+            unsigned char high = 0xBF;
+            if (c >= 0xC2 && c <= 0xDF)
+            {
+                count = 1;
+            }
+            else if (c == 0xE0)
+            {
+                // 过长编码
+                count = 2;
+                low = 0xA0;
+            }
+            else if (c == 0xED)
+            {
+                // U+D800 到 U+DFFF 是代理项
+                count = 2;
+                high = 0x9F;
+            }
+            else if (c >= 0xE1 && c <= 0xEF)
+            {
+                count = 2;
+            }
+            else if (c == 0xF0)
+            {
+                count = 3;
+                low = 0x90;
+            }
+            else if (c >= 0xF1 && c <= 0xF3)
+            {
+                count = 3;
+            }
+            else if (c == 0xF4)
+            {
+                // 不超过 U+10FFFF
+                count = 3;
+                high = 0x8F;
+            }
+            else
+            {
+                return nullptr;
+            }
+
+            const char *p = first + 1;
+            for (int i = 0; i < count; i++, p++)
+            {
+                if (p == last)
+                {
+                    truncated = true;
+                    return last;
+                }
+                unsigned char b = *p;
+                if (b < low || b > high)
+                {
+                    return nullptr;
+                }
+                low = 0x80;
+                high = 0xBF;
+            }
+            return p;
+        }
+
+        // 整段校验 UTF-8
+        bool validateUtf8(std::string_view source);
+
+        // 将 unicode 码点编码为 UTF-8
+        void appendUtf8(std::string &out, uint32_t code);
+    }
+}
@@ -0,0 +1,371 @@
+#include <charconv>
+#include "writer.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 每个字节的转义方式：0 表示原样输出，'u' 表示 \u00XX，其余为 `\` 之后的字符
+        static const struct EscapeTable
+        {
+            char table[256] = {};
+
+            EscapeTable()
+            {
+                for (int c = 0; c < 0x20; c++)
+                {
+                    this->table[c] = 'u';
+                }
+                this->table[(unsigned char)'\b'] = 'b';
+                this->table[(unsigned char)'\f'] = 'f';
+                this->table[(unsigned char)'\n'] = 'n';
+                this->table[(unsigned char)'\r'] = 'r';
+                this->table[(unsigned char)'\t'] = 't';
+                this->table[(unsigned char)'"'] = '"';
+                this->table[(unsigned char)'\\'] = '\\';
+            }
+
+            char operator[](char c) const { return this->table[(unsigned char)c]; }
+        } ESCAPE;
+
+        // 序列化整棵树
+        void Writer::write(JsonElement *element)
+        {
+            // 显式栈中的一层，记录容器中下一个要写的位置
+            struct Frame
+            {
+                JsonElement *container;
+                JsonObject::iterator object;
+                size_t index;
+            };
+            std::vector<Frame> stack;
+
+            JsonElement *next = element;
+            while (true)
+            {
+                if (next != nullptr)
+                {
+                    switch (next->type())
+                    {
+                    case JsonElement::Type::JSON_OBJECT:
+                    {
+                        this->onStartObject();
+                        stack.push_back({next, next->asObject()->begin(), 0});
+                        break;
+                    }
+                    case JsonElement::Type::JSON_ARRAY:
+                    {
+                        this->onStartArray();
+                        stack.push_back({next, {}, 0});
+                        break;
+                    }
+                    case JsonElement::Type::JSON_STRING:
+                    {
+                        this->onString(*next->asString());
+                        break;
+                    }
+                    case JsonElement::Type::JSON_NUMBER:
+                    {
+                        Number number;
+                        number.type = next->numberType();
+                        if (number.type == NumberType::INT64)
+                        {
+                            number.int64 = next->asInt64();
+                        }
+                        else if (number.type == NumberType::UINT64)
+                        {
+                            number.uint64 = next->asUInt64();
+                        }
+                        else
+                        {
+                            number.float64 = next->asNumber();
+                        }
+                        this->onNumber(number);
+                        break;
+                    }
+                    case JsonElement::Type::JSON_BOOL:
+                    {
+                        this->onBool(next->asBool());
+                        break;
+                    }
+                    default:
+                    {
+                        this->onNull();
+                        break;
+                    }
+                    }
+                    next = nullptr;
+                }
+
+                if (stack.empty())
+                {
+                    break;
+                }
+
+                Frame &frame = stack.back();
+                if (frame.container->type() == JsonElement::Type::JSON_OBJECT)
+                {
+                    if (frame.object == frame.container->asObject()->end())
+                    {
+                        stack.pop_back();
+                        this->onEndObject();
+                        continue;
+                    }
+                    this->onKey(frame.object->first);
+                    next = frame.object->second;
+                    ++frame.object;
+                }
+                else
+                {
+                    JsonArray *array = frame.container->asArray();
+                    if (frame.index == array->size())
+                    {
+                        stack.pop_back();
+                        this->onEndArray();
+                        continue;
+                    }
+                    next = (*array)[frame.index++];
+                }
+            }
+        }
+
+        // 把缓冲写入 FILE*
+        void Writer::flush()
+        {
+            if (this->file_ != nullptr && !this->buffer_.empty())
+            {
+                fwrite(this->buffer_.data(), 1, this->buffer_.size(), this->file_);
+                this->buffer_.clear();
+            }
+        }
+
+        // 丢弃未闭合的容器状态
+        void Writer::reset()
+        {
+            this->first_.clear();
+            this->after_key_ = false;
+        }
+
+        bool Writer::onNull()
+        {
+            this->separator();
+            this->out_->append("null", 4);
+            this->endValue();
+            return true;
+        }
+
+        bool Writer::onBool(bool value)
+        {
+            this->separator();
+            if (value)
+            {
+                this->out_->append("true", 4);
+            }
+            else
+            {
+                this->out_->append("false", 5);
+            }
+            this->endValue();
+            return true;
+        }
+
+        bool Writer::onNumber(const Number &value)
+        {
+            this->separator();
+
+            char buffer[32];
+            char *last = buffer;
+            switch (value.type)
+            {
+            case NumberType::INT64:
+            {
+                last = std::to_chars(buffer, buffer + sizeof(buffer), value.int64).ptr;
+                break;
+            }
+            case NumberType::UINT64:
+            {
+                last = std::to_chars(buffer, buffer + sizeof(buffer), value.uint64).ptr;
+                break;
+            }
+            default:
+            {
+                // JSON 中没有 inf 与 nan，输出为 null
+                if (value.float64 - value.float64 != 0)
+                {
+                    this->out_->append("null", 4);
+                    this->endValue();
+                    return true;
+                }
+                last = formatDouble(buffer, buffer + sizeof(buffer), value.float64);
+                break;
+            }
+            }
+            this->out_->append(buffer, last - buffer);
+            this->endValue();
+            return true;
+        }
+
+        bool Writer::onString(std::string_view value)
+        {
+            this->separator();
+            this->writeString(value);
+            this->endValue();
+            return true;
+        }
+
+        bool Writer::onKey(std::string_view key)
+        {
+            this->separator();
+            this->writeString(key);
+            if (this->indent_ > 0)
+            {
+                this->out_->append(": ", 2);
+            }
+            else
+            {
+                this->out_->push_back(':');
+            }
+            this->after_key_ = true;
+            return true;
+        }
+
+        bool Writer::onStartObject()
+        {
+            this->separator();
+            this->out_->push_back('{');
+            this->first_.push_back(true);
+            return true;
+        }
+
+        bool Writer::onEndObject()
+        {
+            this->close('}');
+            return true;
+        }
+
+        bool Writer::onStartArray()
+        {
+            this->separator();
+            this->out_->push_back('[');
+            this->first_.push_back(true);
+            return true;
+        }
+
+        bool Writer::onEndArray()
+        {
+            this->close(']');
+            return true;
+        }
+
+        // 写值之前输出 , 与换行缩进
+        void Writer::separator()
+        {
+            // key 之后的值紧跟在 : 后面
+            if (this->after_key_)
+            {
+                this->after_key_ = false;
+                return;
+            }
+            if (this->first_.empty())
+            {
+                return;
+            }
+            if (this->first_.back())
+            {
+                this->first_.back() = false;
+            }
+            else
+            {
+                this->out_->push_back(',');
+            }
+            this->newline(this->first_.size());
+        }
+
+        // 容器结束，非空容器的结束符单独一行
+        void Writer::close(char c)
+        {
+            bool empty = this->first_.back();
+            this->first_.pop_back();
+            if (!empty)
+            {
+                this->newline(this->first_.size());
+            }
+            this->out_->push_back(c);
+            this->endValue();
+        }
+
+        // 换行并缩进 depth 层
+        void Writer::newline(size_t depth)
+        {
+            if (this->indent_ > 0)
+            {
+                this->out_->push_back('\n');
+                this->out_->append(depth * this->indent_, ' ');
+            }
+        }
+
+        // 写入带引号并转义后的字符串，不需要转义的部分整段拷贝
+        void Writer::writeString(std::string_view value)
+        {
+            static const char HEX[] = "0123456789abcdef";
+
+            std::string &out = *this->out_;
+            out.push_back('"');
+
+            const char *p = value.data();
+            const char *last = p + value.size();
+            while (p != last)
+            {
+                const char *run = p;
+                while (p != last && ESCAPE[*p] == 0)
+                {
+                    p++;
+                }
+                out.append(run, p - run);
+                if (p == last)
+                {
+                    break;
+                }
+
+                char escape = ESCAPE[*p];
+                if (escape == 'u')
+                {
+                    char code[6] = {'\\', 'u', '0', '0', HEX[(unsigned char)*p >> 4], HEX[*p & 0xF]};
+                    out.append(code, sizeof(code));
+                }
+                else
+                {
+                    char code[2] = {'\\', escape};
+                    out.append(code, sizeof(code));
+                }
+                p++;
+            }
+
+            out.push_back('"');
+        }
+
+        // 一个值写完，FILE* 模式下缓冲足够大时写出
+        void Writer::endValue()
+        {
+            if (this->file_ != nullptr && this->buffer_.size() >= FLUSH_SIZE)
+            {
+                this->flush();
+            }
+        }
+
+        // 转成字符串
+        std::string JsonElement::dumps(int indent)
+        {
+            std::string result;
+            Writer writer(result, indent);
+            writer.write(this);
+            return result;
+        }
+
+        // 以紧凑格式输出
+        std::ostream &operator<<(std::ostream &os, JsonElement &element)
+        {
+            return os << element.dumps();
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "handler.h"
+#include "jsonElement.h"
+
+namespace civitasv
+{
+    namespace json
+    {
+        // 单趟序列化，把 SAX 事件或 JsonElement 树写成 JSON 文本
+        // 输出追加到调用方提供的 std::string 中（可复用同一块内存），或者经内部缓冲写入 FILE*
+        // 字符串按 JSON 规范转义，indent 为 0 时输出紧凑格式，否则每层缩进 indent 个空格
+        class Writer : public JsonHandler
+        {
+        public:
+            // 写入 FILE* 时，缓冲超过该大小就写出一次
+            static constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+            explicit Writer(std::string &buffer, int indent = 0) : out_(&buffer), indent_(indent) {}
+
+            explicit Writer(FILE *file, int indent = 0) : out_(&this->buffer_), file_(file), indent_(indent)
+            {
+                this->buffer_.reserve(FLUSH_SIZE * 2);
+            }
+
+            ~Writer() override { this->flush(); }
+
+            Writer(const Writer &) = delete;
+            Writer &operator=(const Writer &) = delete;
+
+            // 序列化整棵树，使用显式栈，不受嵌套深度限制
+            void write(JsonElement *element);
+
+            // 把缓冲写入 FILE*，输出到 std::string 时什么也不做
+            void flush();
+
+            // 准备写下一个值，丢弃未闭合的容器状态
+            void reset();
+
+            bool onNull() override;
+
+            bool onBool(bool value) override;
+
+            bool onNumber(const Number &value) override;
+
+            bool onString(std::string_view value) override;
+
+            bool onKey(std::string_view key) override;
+
+            bool onStartObject() override;
+
+            bool onEndObject() override;
+
+            bool onStartArray() override;
+
+            bool onEndArray() override;
+
+        private:
+            // 写值之前输出 , 与换行缩进
+            void separator();
+
+            // 容器结束之前输出换行缩进
+            void close(char c);
+
+            // 换行并缩进 depth 层
+            void newline(size_t depth);
+
+            // 写入带引号并转义后的字符串
+            void writeString(std::string_view value);
+
+            // 一个值写完，FILE* 模式下缓冲足够大时写出
+            void endValue();
+
+        private:
+            // 内部缓冲，写入 FILE* 时使用
+            std::string buffer_;
+            // 实际写入的位置
+            std::string *out_;
+            FILE *file_ = nullptr;
+            int indent_;
+            // 未闭合的容器中是否还没有写过值
+            std::vector<bool> first_;
+            // 刚写完 key，下一个值不需要分隔符
+            bool after_key_ = false;
+        };
+
+        // 以紧凑格式输出
+        std::ostream &operator<<(std::ostream &os, JsonElement &element);
+    }
+}
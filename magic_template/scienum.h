@@ -1,6 +1,8 @@
 #pragma once
 
+#include <limits>
 #include <string>
+#include <type_traits>
 
 namespace scienum
 {
@@ -28,7 +30,7 @@ namespace scienum
         };
 
         template <int beg, int end, class F>
-        typename my_enable_if<beg == end>::type static_for(F const &func)
+        typename my_enable_if<beg == end>::type static_for(F const & /*func*/)
         {
         }
 
@@ -61,11 +63,19 @@ namespace scienum
 
     }
 
+    // 默认扫描的最大值 256，不超过底层类型的最大值，否则 uint8_t 等窄类型上 (T)256 会回绕为 0
+    template <class T>
+    constexpr int enum_scan_end()
+    {
+        using U = std::underlying_type_t<T>;
+        return std::numeric_limits<U>::max() < 256 ? int(std::numeric_limits<U>::max()) : 256;
+    }
+
     template <class T, T beg, T end>
     std::string get_enum_name(T n)
     {
         std::string s;
-        details::static_for<beg, end + 1>(details::get_enum_name_functor<T>(n, s));
+        details::static_for<(int)beg, (int)end + 1>(details::get_enum_name_functor<T>((int)n, s));
 
         if (s.empty())
         {
@@ -95,7 +105,7 @@ namespace scienum
     template <class T>
     std::string get_enum_name(T n)
     {
-        return get_enum_name<T, (T)0, (T)256>(n);
+        return get_enum_name<T, (T)0, (T)enum_scan_end<T>()>(n);
     }
 
     template <class T, T beg, T end>
@@ -114,6 +124,6 @@ namespace scienum
     template <class T>
     T enum_from_name(std::string const &s)
     {
-        return enum_from_name<T, (T)0, (T)256>(s);
+        return enum_from_name<T, (T)0, (T)enum_scan_end<T>()>(s);
     }
 }
\ No newline at end of file